@@ -0,0 +1,164 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// DB postprocessing on a synthetic probability map with many text lines:
+// time of the ClipperLib unclip against the closed form one and how far
+// their boxes are apart, polygon scoring through a mask, spans and row sums,
+// and the time of the whole BoxesFromBitmap.
+//
+//   ./build/db_postprocess_benchmark [iterations] [lines]
+
+#include <include/postprocess_op.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace PaddleOCR;
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 20;
+  int lines = argc > 2 ? atoi(argv[2]) : 600;
+  const float unclip_ratio = 1.5f;
+  const float box_thresh = 0.6f;
+
+  // text lines of a dense page in a 960 x 1280 det map, slightly rotated
+  cv::RNG rng(0);
+  cv::Mat bitmap = cv::Mat::zeros(1280, 960, CV_8UC1);
+  for (int i = 0; i < lines; i++) {
+    cv::RotatedRect line(
+        cv::Point2f(rng.uniform(20.f, 940.f), rng.uniform(10.f, 1270.f)),
+        cv::Size2f(rng.uniform(16.f, 240.f), rng.uniform(6.f, 14.f)),
+        rng.uniform(-8.f, 8.f));
+    cv::Point2f corners[4];
+    line.points(corners);
+    std::vector<cv::Point> poly;
+    for (int j = 0; j < 4; j++) {
+      poly.push_back(cv::Point(int(corners[j].x), int(corners[j].y)));
+    }
+    cv::fillConvexPoly(bitmap, poly, cv::Scalar(255));
+  }
+  cv::Mat pred;
+  bitmap.convertTo(pred, CV_32F, 0.9 / 255);
+
+  DBPostProcessor post_processor;
+  std::vector<std::vector<cv::Point>> contours;
+  cv::findContours(bitmap.clone(), contours, cv::RETR_LIST,
+                   cv::CHAIN_APPROX_SIMPLE);
+  std::vector<QuadF> boxes;
+  for (size_t i = 0; i < contours.size(); i++) {
+    float ssid;
+    boxes.push_back(
+        post_processor.GetMiniBoxes(cv::minAreaRect(contours[i]), ssid));
+  }
+
+  std::vector<cv::RotatedRect> clipper(boxes.size());
+  std::vector<cv::RotatedRect> closed(boxes.size());
+  auto clipper_start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (size_t i = 0; i < boxes.size(); i++) {
+      clipper[i] = post_processor.UnClipPolygon(boxes[i], unclip_ratio);
+    }
+  }
+  std::chrono::duration<float> clipper_diff =
+      std::chrono::steady_clock::now() - clipper_start;
+  auto closed_start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (size_t i = 0; i < boxes.size(); i++) {
+      closed[i] = post_processor.UnClip(boxes[i], unclip_ratio);
+    }
+  }
+  std::chrono::duration<float> closed_diff =
+      std::chrono::steady_clock::now() - closed_start;
+
+  // compare the corners both boxes end up with
+  float max_diff = 0.f;
+  for (size_t i = 0; i < boxes.size(); i++) {
+    float ssid;
+    auto a = post_processor.GetMiniBoxes(clipper[i], ssid);
+    auto b = post_processor.GetMiniBoxes(closed[i], ssid);
+    for (int j = 0; j < 4; j++) {
+      max_diff = std::max(max_diff, std::fabs(a[j][0] - b[j][0]));
+      max_diff = std::max(max_diff, std::fabs(a[j][1] - b[j][1]));
+    }
+  }
+
+  // polygon scores: fillPoly mask, spans, spans over row sums
+  std::vector<float> mask_score(contours.size());
+  std::vector<float> span_score(contours.size());
+  std::vector<float> sums_score(contours.size());
+  auto mask_start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (size_t i = 0; i < contours.size(); i++) {
+      mask_score[i] = post_processor.MaskScore(
+          contours[i].data(), int(contours[i].size()), pred);
+    }
+  }
+  std::chrono::duration<float> mask_diff =
+      std::chrono::steady_clock::now() - mask_start;
+  auto span_start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (size_t i = 0; i < contours.size(); i++) {
+      span_score[i] = post_processor.PolygonScore(
+          contours[i].data(), int(contours[i].size()), pred);
+    }
+  }
+  std::chrono::duration<float> span_diff =
+      std::chrono::steady_clock::now() - span_start;
+  auto sums_start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    cv::Mat sums;
+    DBPostProcessor::RowSums(pred, sums);
+    for (size_t i = 0; i < contours.size(); i++) {
+      sums_score[i] = post_processor.PolygonScore(
+          contours[i].data(), int(contours[i].size()), pred, sums);
+    }
+  }
+  std::chrono::duration<float> sums_diff =
+      std::chrono::steady_clock::now() - sums_start;
+  float max_score_diff = 0.f;
+  for (size_t i = 0; i < contours.size(); i++) {
+    max_score_diff =
+        std::max(max_score_diff, std::fabs(mask_score[i] - span_score[i]));
+    max_score_diff =
+        std::max(max_score_diff, std::fabs(mask_score[i] - sums_score[i]));
+  }
+
+  auto boxes_start = std::chrono::steady_clock::now();
+  size_t found = 0;
+  for (int it = 0; it < iterations; it++) {
+    found = post_processor
+                .BoxesFromBitmap(pred, bitmap, box_thresh, unclip_ratio,
+                                 "slow")
+                .size();
+  }
+  std::chrono::duration<float> boxes_diff =
+      std::chrono::steady_clock::now() - boxes_start;
+
+  double clipper_ms = clipper_diff.count() * 1000 / iterations;
+  double closed_ms = closed_diff.count() * 1000 / iterations;
+  std::cout << contours.size() << " contours: unclip clipper " << clipper_ms
+            << " ms, closed form " << closed_ms << " ms, speedup "
+            << clipper_ms / closed_ms << "x, max corner diff " << max_diff
+            << " px" << std::endl;
+  std::cout << "polygon score: mask " << mask_diff.count() * 1000 / iterations
+            << " ms, spans " << span_diff.count() * 1000 / iterations
+            << " ms, spans over row sums "
+            << sums_diff.count() * 1000 / iterations
+            << " ms, max score diff " << max_score_diff << std::endl;
+  std::cout << "BoxesFromBitmap: " << boxes_diff.count() * 1000 / iterations
+            << " ms, " << found << " boxes" << std::endl;
+  return 0;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Loads a det model as is and with --det_map_output=uint8 and compares, on
+// random inputs of a few page sizes, the bitmap and uint8 map computed in
+// the graph with the C++ threshold and quantization of the float map.
+//
+//   ./build/det_bitmap_check <det model.onnx> [thresh]
+
+#include <include/onnx_model.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace PaddleOCR;
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <det model.onnx> [thresh]"
+              << std::endl;
+    return 1;
+  }
+  const double thresh = argc > 2 ? atof(argv[2]) : 0.3;
+
+  RuntimeProfile profile;
+  profile.load_mode = "serial";
+  OnnxModel plain;
+  plain.LoadModel(argv[1], "det_plain", profile);
+  OnnxModel rewritten;
+  rewritten.SetOutputBitmap(float(thresh), true);
+  rewritten.LoadModel(argv[1], "det_bitmap", profile);
+  if (!rewritten.OutputBitmap()) {
+    std::cerr << "[ERROR] the model was not rewritten" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> value(-2.f, 2.f);
+  const int sizes[][2] = {{320, 320}, {640, 480}, {960, 736}};
+  bool ok = true;
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    std::vector<int64_t> shape = {1, 3, sizes[s][0], sizes[s][1]};
+    size_t count = size_t(3 * sizes[s][0] * sizes[s][1]);
+    float *plain_input = plain.InputData(shape);
+    float *rewritten_input = rewritten.InputData(shape);
+    for (size_t i = 0; i < count; i++) {
+      plain_input[i] = rewritten_input[i] = value(rng);
+    }
+    plain.Run();
+    rewritten.Run();
+
+    // the same threshold as DBDetector::Run on the float map
+    const float threshold = float(thresh * 255);
+    const float *pred = plain.OutputData();
+    const uint8_t *map = rewritten.ByteOutputData(0);
+    const uint8_t *bitmap = rewritten.ByteOutputData(1);
+    int64_t n = plain.OutputSize();
+    int64_t set = 0, bitmap_diff = 0, map_diff = 0;
+    for (int64_t i = 0; i < n; i++) {
+      unsigned char q = (unsigned char)(pred[i] * 255);
+      bool host = float(q) > threshold;
+      set += host;
+      bitmap_diff += host != (bitmap[i] != 0);
+      map_diff += q != map[i];
+    }
+    std::cout << sizes[s][1] << "x" << sizes[s][0] << ": " << n
+              << " pixels, " << set << " set, bitmap differs at "
+              << bitmap_diff << ", uint8 map at " << map_diff << std::endl;
+    ok = ok && bitmap_diff == 0 && map_diff == 0;
+  }
+  std::cout << (ok ? "OK" : "MISMATCH") << std::endl;
+  return ok ? 0 : 1;
+}
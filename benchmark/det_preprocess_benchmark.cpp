@@ -0,0 +1,79 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the det preprocessing op chain (ResizeImgType0 + Normalize +
+// Permute) with the fused ResizeNormalizePermute kernel on random pages.
+//
+//   ./build/det_preprocess_benchmark [iterations]
+
+#include <include/preprocess_op.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace PaddleOCR;
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 50;
+  const std::vector<float> mean = {0.485f, 0.456f, 0.406f};
+  const std::vector<float> scale = {1 / 0.229f, 1 / 0.224f, 1 / 0.225f};
+  // photo, A4 at 150 dpi, A4 at 300 dpi
+  const std::vector<cv::Size> pages = {
+      cv::Size(1280, 960), cv::Size(1240, 1754), cv::Size(2480, 3508)};
+
+  ResizeImgType0 resize_op;
+  Normalize normalize_op;
+  Permute permute_op;
+  ResizeNormalizePermute fused_op;
+
+  for (size_t i = 0; i < pages.size(); i++) {
+    cv::Mat img(pages[i], CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Size size = resize_op.TargetSize(img, "max", 960);
+    std::vector<float> chain_out(size_t(size.area()) * 3);
+    std::vector<float> fused_out(size_t(size.area()) * 3);
+
+    auto chain_start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+      cv::Mat resize_img;
+      float ratio_h, ratio_w;
+      resize_op.Run(img, resize_img, "max", 960, ratio_h, ratio_w, false);
+      normalize_op.Run(&resize_img, mean, scale, true);
+      permute_op.Run(&resize_img, chain_out.data());
+    }
+    std::chrono::duration<float> chain_diff =
+        std::chrono::steady_clock::now() - chain_start;
+
+    auto fused_start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+      fused_op.Run(img, size, mean, scale, true, fused_out.data());
+    }
+    std::chrono::duration<float> fused_diff =
+        std::chrono::steady_clock::now() - fused_start;
+
+    float max_diff = 0.f;
+    for (size_t j = 0; j < chain_out.size(); j++) {
+      max_diff = std::max(max_diff, std::fabs(chain_out[j] - fused_out[j]));
+    }
+    double chain_ms = chain_diff.count() * 1000 / iterations;
+    double fused_ms = fused_diff.count() * 1000 / iterations;
+    std::cout << img.cols << "x" << img.rows << " -> " << size.width << "x"
+              << size.height << ": op chain " << chain_ms << " ms, fused "
+              << fused_ms << " ms, speedup " << chain_ms / fused_ms
+              << "x, max abs diff " << max_diff << std::endl;
+  }
+  return 0;
+}
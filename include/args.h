@@ -22,6 +22,32 @@ DECLARE_bool(use_tensorrt);
 DECLARE_int32(gpu_id);
 DECLARE_int32(gpu_mem);
 DECLARE_int32(cpu_threads);
+DECLARE_bool(use_global_thread_pool);
+DECLARE_string(runtime_profile);
+DECLARE_int32(intra_op_threads);
+DECLARE_int32(inter_op_threads);
+DECLARE_string(execution_mode);
+DECLARE_string(graph_optimization_level);
+DECLARE_bool(enable_mem_pattern);
+DECLARE_bool(enable_cpu_mem_arena);
+DECLARE_bool(allow_spinning);
+DECLARE_string(runtime_config);
+DECLARE_string(det_runtime_options);
+DECLARE_string(cls_runtime_options);
+DECLARE_string(rec_runtime_options);
+DECLARE_string(table_runtime_options);
+DECLARE_string(layout_runtime_options);
+DECLARE_bool(model_cache);
+DECLARE_string(model_cache_dir);
+DECLARE_string(model_cache_format);
+DECLARE_string(model_load_mode);
+DECLARE_bool(fold_normalize);
+DECLARE_bool(argmax_output);
+DECLARE_int32(page_workers);
+DECLARE_int32(rec_pool_pages);
+DECLARE_bool(pipeline);
+DECLARE_int32(pipeline_queue_size);
+DECLARE_int32(pipeline_rec_workers);
 DECLARE_bool(enable_mkldnn);
 DECLARE_string(precision);
 DECLARE_bool(benchmark);
@@ -36,6 +62,8 @@ DECLARE_double(det_db_thresh);
 DECLARE_double(det_db_box_thresh);
 DECLARE_double(det_db_unclip_ratio);
 DECLARE_bool(use_dilation);
+DECLARE_bool(det_fused_preprocess);
+DECLARE_string(det_map_output);
 DECLARE_string(det_db_score_mode);
 DECLARE_bool(visualize);
 // classification related
@@ -43,12 +71,20 @@ DECLARE_bool(use_angle_cls);
 DECLARE_string(cls_model_dir);
 DECLARE_double(cls_thresh);
 DECLARE_int32(cls_batch_num);
+DECLARE_int32(cls_vote_samples);
+DECLARE_double(cls_vote_margin);
+DECLARE_double(cls_after_rec_thresh);
 // recognition related
 DECLARE_string(rec_model_dir);
 DECLARE_int32(rec_batch_num);
+DECLARE_int32(rec_batch_width);
+DECLARE_double(rec_max_pad_ratio);
+DECLARE_double(rec_max_wh_ratio);
+DECLARE_double(rec_chunk_overlap);
 DECLARE_string(rec_char_dict_path);
 DECLARE_int32(rec_img_h);
 DECLARE_int32(rec_img_w);
+DECLARE_bool(rec_direct_crop);
 // layout model related
 DECLARE_string(layout_model_dir);
 DECLARE_string(layout_dict_path);
@@ -0,0 +1,88 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace PaddleOCR {
+
+// Bounded FIFO between pipeline stages. Push() blocks while the queue is
+// full, so a fast stage cannot run ahead of a slow one and pile up pages in
+// memory. Pop() blocks until an item arrives, and returns false once the
+// queue is closed and drained. Cancel() stops both sides at once.
+template <class T> class BlockingQueue {
+public:
+  explicit BlockingQueue(size_t capacity)
+      : capacity_(std::max(capacity, size_t(1))) {}
+
+  // False, dropping `item`, once the queue is cancelled.
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->not_full_.wait(lock, [this]() {
+      return this->items_.size() < this->capacity_ || this->cancelled_;
+    });
+    if (this->cancelled_) {
+      return false;
+    }
+    this->items_.push_back(std::move(item));
+    this->not_empty_.notify_one();
+    return true;
+  }
+
+  bool Pop(T &item) {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->not_empty_.wait(
+        lock, [this]() { return !this->items_.empty() || this->closed_; });
+    if (this->items_.empty()) {
+      return false;
+    }
+    item = std::move(this->items_.front());
+    this->items_.pop_front();
+    this->not_full_.notify_one();
+    return true;
+  }
+
+  // No more items will be pushed, wake every waiting consumer.
+  void Close() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->closed_ = true;
+    this->not_empty_.notify_all();
+  }
+
+  // Drop what is queued and wake everyone: Pop() and Push() return false
+  // from now on, so no stage keeps waiting on one that has stopped.
+  void Cancel() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->items_.clear();
+    this->closed_ = true;
+    this->cancelled_ = true;
+    this->not_empty_.notify_all();
+    this->not_full_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> items_;
+  size_t capacity_;
+  bool closed_ = false;
+  bool cancelled_ = false;
+};
+
+} // namespace PaddleOCR
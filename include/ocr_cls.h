@@ -14,8 +14,7 @@
 
 #pragma once
 
-#include <onnxruntime_cxx_api.h>
-
+#include <include/onnx_model.h>
 #include <include/preprocess_op.h>
 #include <include/utility.h>
 
@@ -28,12 +27,14 @@ public:
                       const int &cpu_math_library_num_threads,
                       const bool &use_mkldnn, const double &cls_thresh,
                       const bool &use_tensorrt, const std::string &precision,
-                      const int &cls_batch_num) {
+                      const int &cls_batch_num,
+                      const RuntimeProfile &runtime_profile) {
     this->use_gpu_ = use_gpu;
     this->gpu_id_ = gpu_id;
     this->gpu_mem_ = gpu_mem;
     this->cpu_math_library_num_threads_ = cpu_math_library_num_threads;
     this->use_mkldnn_ = use_mkldnn;
+    this->runtime_profile_ = runtime_profile;
 
     this->cls_thresh = cls_thresh;
     this->use_tensorrt_ = use_tensorrt;
@@ -46,15 +47,16 @@ public:
 
   // Load Paddle inference model
   void LoadModel(const std::string &model_dir);
+  // ms spent loading the model, 0 until it is loaded
+  double LoadTime() const { return this->model_.LoadTime(); }
 
   void Run(std::vector<cv::Mat> img_list, std::vector<int> &cls_labels,
            std::vector<float> &cls_scores, std::vector<double> &times);
 
 private:
   // std::shared_ptr<paddle_infer::Predictor> predictor_;
-  Ort::Session *session;
-  Ort::Env env = Ort::Env(ORT_LOGGING_LEVEL_ERROR, "ocr_cls");
-  Ort::SessionOptions sessionOptions = Ort::SessionOptions();
+  OnnxModel model_;
+  RuntimeProfile runtime_profile_;
 
   bool use_gpu_ = false;
   int gpu_id_ = 0;
@@ -70,8 +72,8 @@ private:
   int cls_batch_num_ = 1;
   // pre-process
   ClsResizeImg resize_op_;
-  Normalize normalize_op_;
-  PermuteBatch permute_op_;
+  PackBatch pack_op_;
+  ResizeNormalizeBatch batch_op_;
 
 }; // class Classifier
 
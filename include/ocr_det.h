@@ -14,8 +14,7 @@
 
 #pragma once
 
-#include <onnxruntime_cxx_api.h>
-
+#include <include/onnx_model.h>
 #include <include/postprocess_op.h>
 #include <include/preprocess_op.h>
 
@@ -32,12 +31,16 @@ public:
                       const double &det_db_unclip_ratio,
                       const std::string &det_db_score_mode,
                       const bool &use_dilation, const bool &use_tensorrt,
-                      const std::string &precision) {
+                      const std::string &precision,
+                      const bool &use_fused_preprocess,
+                      const std::string &det_map_output,
+                      const RuntimeProfile &runtime_profile) {
     this->use_gpu_ = use_gpu;
     this->gpu_id_ = gpu_id;
     this->gpu_mem_ = gpu_mem;
     this->cpu_math_library_num_threads_ = cpu_math_library_num_threads;
     this->use_mkldnn_ = use_mkldnn;
+    this->runtime_profile_ = runtime_profile;
 
     this->limit_type_ = limit_type;
     this->limit_side_len_ = limit_side_len;
@@ -47,6 +50,14 @@ public:
     this->det_db_unclip_ratio_ = det_db_unclip_ratio;
     this->det_db_score_mode_ = det_db_score_mode;
     this->use_dilation_ = use_dilation;
+    this->use_fused_preprocess_ = use_fused_preprocess;
+    if (det_map_output != "float" && det_map_output != "bitmap" &&
+        det_map_output != "uint8") {
+      std::cerr << "[ERROR] det_map_output should be float, bitmap or uint8, "
+                << "got: " << det_map_output << std::endl;
+      exit(1);
+    }
+    this->det_map_output_ = det_map_output;
 
     this->use_tensorrt_ = use_tensorrt;
     this->precision_ = precision;
@@ -56,16 +67,16 @@ public:
 
   // Load Paddle inference model
   void LoadModel(const std::string &model_dir);
+  // ms spent loading the model, 0 until it is loaded
+  double LoadTime() const { return this->model_.LoadTime(); }
 
   // Run predictor
-  void Run(cv::Mat &img, std::vector<std::vector<std::vector<int>>> &boxes,
-           std::vector<double> &times);
+  void Run(cv::Mat &img, std::vector<Quad> &boxes, std::vector<double> &times);
 
 private:
   // std::shared_ptr<paddle_infer::Predictor> predictor_;
-  Ort::Session *session;
-  Ort::Env env = Ort::Env(ORT_LOGGING_LEVEL_ERROR, "ocr_det");
-  Ort::SessionOptions sessionOptions = Ort::SessionOptions();
+  OnnxModel model_;
+  RuntimeProfile runtime_profile_;
 
   bool use_gpu_ = false;
   int gpu_id_ = 0;
@@ -81,6 +92,10 @@ private:
   double det_db_unclip_ratio_ = 2.0;
   std::string det_db_score_mode_ = "slow";
   bool use_dilation_ = false;
+  bool use_fused_preprocess_ = true;
+  // what the model outputs: the float map ("float"), also the thresholded
+  // bitmap ("bitmap") or the bitmap and the map quantized to uint8 ("uint8")
+  std::string det_map_output_ = "float";
 
   bool visualize_ = true;
   bool use_tensorrt_ = false;
@@ -94,6 +109,7 @@ private:
   ResizeImgType0 resize_op_;
   Normalize normalize_op_;
   Permute permute_op_;
+  ResizeNormalizePermute fused_preprocess_op_;
 
   // post-process
   DBPostProcessor post_processor_;
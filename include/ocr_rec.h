@@ -14,13 +14,24 @@
 
 #pragma once
 
-#include <onnxruntime_cxx_api.h>
-
+#include <include/onnx_model.h>
 #include <include/ocr_cls.h>
 #include <include/utility.h>
 
 namespace PaddleOCR {
 
+// Shapes of the batches run so far and how much of them was padding.
+struct RecBatchStats {
+  // (batch size, batch width) -> number of batches
+  std::map<std::pair<int, int>, int> shapes;
+  // input columns of all batches, and those covered by a resized crop
+  double padded_cols = 0;
+  double valid_cols = 0;
+
+  void Merge(const RecBatchStats &other);
+  void Reset();
+};
+
 class CRNNRecognizer {
 public:
   explicit CRNNRecognizer(const std::string &model_dir, const bool &use_gpu,
@@ -30,17 +41,26 @@ public:
                           const bool &use_tensorrt,
                           const std::string &precision,
                           const int &rec_batch_num, const int &rec_img_h,
-                          const int &rec_img_w) {
+                          const int &rec_img_w, const int &rec_batch_width,
+                          const double &rec_max_pad_ratio,
+                          const double &rec_max_wh_ratio,
+                          const double &rec_chunk_overlap,
+                          const RuntimeProfile &runtime_profile) {
     this->use_gpu_ = use_gpu;
     this->gpu_id_ = gpu_id;
     this->gpu_mem_ = gpu_mem;
     this->cpu_math_library_num_threads_ = cpu_math_library_num_threads;
     this->use_mkldnn_ = use_mkldnn;
+    this->runtime_profile_ = runtime_profile;
     this->use_tensorrt_ = use_tensorrt;
     this->precision_ = precision;
     this->rec_batch_num_ = rec_batch_num;
     this->rec_img_h_ = rec_img_h;
     this->rec_img_w_ = rec_img_w;
+    this->rec_batch_width_ = rec_batch_width;
+    this->rec_max_pad_ratio_ = rec_max_pad_ratio;
+    this->rec_max_wh_ratio_ = rec_max_wh_ratio;
+    this->rec_chunk_overlap_ = rec_chunk_overlap;
     std::vector<int> rec_image_shape = {3, rec_img_h, rec_img_w};
     this->rec_image_shape_ = rec_image_shape;
 
@@ -48,21 +68,31 @@ public:
     this->label_list_.insert(this->label_list_.begin(),
                              "#"); // blank char for ctc
     this->label_list_.push_back(" ");
+    // all labels back to back, label i at [offsets[i], offsets[i + 1])
+    this->label_offsets_.push_back(0);
+    for (size_t i = 0; i < this->label_list_.size(); i++) {
+      this->label_data_ += this->label_list_[i];
+      this->label_offsets_.push_back(this->label_data_.size());
+    }
 
     LoadModel(model_dir);
   }
 
   // Load Paddle inference model
   void LoadModel(const std::string &model_dir);
+  // ms spent loading the model, 0 until it is loaded
+  double LoadTime() const { return this->model_.LoadTime(); }
 
   void Run(std::vector<cv::Mat> img_list, std::vector<std::string> &rec_texts,
            std::vector<float> &rec_text_scores, std::vector<double> &times);
 
+  const RecBatchStats &BatchStats() const { return this->batch_stats_; }
+  void ResetBatchStats() { this->batch_stats_.Reset(); }
+
 private:
   // std::shared_ptr<paddle_infer::Predictor> predictor_;
-  Ort::Session *session;
-  Ort::Env env = Ort::Env(ORT_LOGGING_LEVEL_ERROR, "ocr_rec");
-  Ort::SessionOptions sessionOptions = Ort::SessionOptions();
+  OnnxModel model_;
+  RuntimeProfile runtime_profile_;
 
   bool use_gpu_ = false;
   int gpu_id_ = 0;
@@ -71,6 +101,8 @@ private:
   bool use_mkldnn_ = false;
 
   std::vector<std::string> label_list_;
+  std::string label_data_;
+  std::vector<size_t> label_offsets_;
 
   std::vector<float> mean_ = {0.5f, 0.5f, 0.5f};
   std::vector<float> scale_ = {1 / 0.5f, 1 / 0.5f, 1 / 0.5f};
@@ -80,11 +112,47 @@ private:
   int rec_batch_num_ = 6;
   int rec_img_h_ = 32;
   int rec_img_w_ = 320;
+  // with a budget > 0, batches are limited by their padded width summed over
+  // the batch instead of by rec_batch_num_
+  int rec_batch_width_ = 0;
+  double rec_max_pad_ratio_ = 0.5;
+  RecBatchStats batch_stats_;
+  // crops wider than rec_max_wh_ratio_ times their height (if > 0) are
+  // split into chunks that overlap by rec_chunk_overlap_ times the height
+  double rec_max_wh_ratio_ = 0;
+  double rec_chunk_overlap_ = 2;
   std::vector<int> rec_image_shape_ = {3, rec_img_h_, rec_img_w_};
   // pre-process
   CrnnResizeImg resize_op_;
-  Normalize normalize_op_;
-  PermuteBatch permute_op_;
+  PackBatch pack_op_;
+  ResizeNormalizeBatch batch_op_;
+
+  // The part of crop `crop` starting at column `x`, the whole crop unless
+  // it was split.
+  struct RecPiece {
+    int crop;
+    int x;
+    int cols;
+  };
+  // A decoded character, `x` is its center in columns of the crop.
+  struct CtcToken {
+    int index;
+    float score;
+    float x;
+  };
+  void SplitWide(const std::vector<cv::Mat> &img_list,
+                 std::vector<cv::Mat> &piece_list,
+                 std::vector<RecPiece> &pieces) const;
+  // Characters of the crop split into pieces [beg, end), left to right.
+  void MergePieces(const std::vector<RecPiece> &pieces,
+                   const std::vector<std::vector<CtcToken>> &piece_tokens,
+                   size_t beg, size_t end, int crop_h,
+                   std::vector<CtcToken> &tokens) const;
+
+  // One past the last crop (in `indices` order) of the batch starting at
+  // `beg`.
+  int BatchEnd(const std::vector<float> &width_list,
+               const std::vector<int> &indices, int beg) const;
 
 }; // class CrnnRecognizer
 
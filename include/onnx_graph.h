@@ -0,0 +1,124 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace PaddleOCR {
+
+// ONNX TensorProto.DataType values used here.
+enum OnnxDataType { ONNX_FLOAT = 1, ONNX_UINT8 = 2, ONNX_INT64 = 7 };
+
+// A graph input or output: name, element type and dims, with -1 and the
+// symbolic name in `dim_params` for dynamic axes.
+struct OnnxValueInfo {
+  std::string name;
+  int elem_type = ONNX_FLOAT;
+  std::vector<int64_t> dims;
+  std::vector<std::string> dim_params;
+};
+
+struct OnnxNode {
+  std::string op_type;
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  std::vector<std::pair<std::string, int64_t>> int_attrs;
+  std::vector<std::pair<std::string, std::vector<int64_t>>> ints_attrs;
+};
+
+// Just enough of the protobuf wire format to edit an exported model at load
+// time without linking protobuf: read the inputs, outputs and opset, splice
+// nodes in front of or behind the existing ones, add initializers and
+// replace inputs/outputs. Everything else is carried over byte for byte.
+class OnnxGraph {
+public:
+  // Parse a serialized ModelProto, false if it does not look like one.
+  bool Parse(const std::string &model);
+  std::string Serialize() const;
+
+  // Version of the default ("ai.onnx") operator set.
+  int64_t OpsetVersion() const { return this->opset_version_; }
+
+  const std::vector<OnnxValueInfo> &Inputs() const { return this->inputs_; }
+  const std::vector<OnnxValueInfo> &Outputs() const { return this->outputs_; }
+  bool IsInitializer(const std::string &name) const;
+
+  void SetInputs(const std::vector<OnnxValueInfo> &inputs);
+  void SetOutputs(const std::vector<OnnxValueInfo> &outputs);
+  // New nodes go before (prepend) or after all existing ones, so the graph
+  // stays topologically sorted as long as they only depend on that side.
+  void PrependNode(const OnnxNode &node);
+  void AppendNode(const OnnxNode &node);
+  void AddInitializer(const std::string &name, const std::vector<int64_t> &dims,
+                      const std::vector<float> &data);
+  void AddInitializer(const std::string &name, const std::vector<int64_t> &dims,
+                      const std::vector<int64_t> &data);
+  void AddInitializer(const std::string &name, const std::vector<int64_t> &dims,
+                      const std::vector<uint8_t> &data);
+
+  // Make the model take the uint8 NHWC image directly: the first 4-D float
+  // NCHW data input is replaced by "<name>_uint8" and Transpose, Cast, Mul
+  // and Add nodes compute what Normalize + Permute used to, i.e.
+  // (x * e - mean) * scale with e = 1/255 if `is_scale`. False, with the
+  // graph untouched, if there is no such input.
+  bool FoldInputNormalize(const std::vector<float> &mean,
+                          const std::vector<float> &scale,
+                          const bool is_scale);
+
+  // Replace the first output, float scores over classes in the last axis,
+  // by two float outputs without that axis: "<name>_index" (ArgMax, first
+  // index on ties) and "<name>_max" (ReduceMax). False, with the graph
+  // untouched, if the first output is not a float tensor of rank >= 2.
+  bool ReduceOutputArgmax();
+
+  // Threshold the first output, a float probability map in [0, 1], inside
+  // the graph: a uint8 output "<name>_bitmap" is added after it, 1 where
+  // the map quantized like (unsigned char)(p * 255) is above
+  // `thresh` * 255 and 0 elsewhere. With `quantize` the first output is
+  // replaced by that quantized map "<name>_uint8". False, with the graph
+  // untouched, if the first output is not float or the opset is below 7.
+  bool ThresholdOutputMap(float thresh, bool quantize);
+
+private:
+  struct Field {
+    int number = 0;
+    int wire_type = 0;
+    uint64_t value = 0;
+    std::string bytes;
+  };
+
+  static bool ParseFields(const std::string &data, std::vector<Field> &fields);
+  static void WriteField(const Field &field, std::string &out);
+  static bool ParseValueInfo(const std::string &data, OnnxValueInfo &info);
+  static std::string EncodeValueInfo(const OnnxValueInfo &info);
+  static std::string EncodeNode(const OnnxNode &node);
+
+  std::vector<Field> model_fields_;
+  std::vector<Field> graph_fields_;
+  int64_t opset_version_ = 0;
+  std::vector<OnnxValueInfo> inputs_;
+  std::vector<OnnxValueInfo> outputs_;
+  std::vector<std::string> initializer_names_;
+  bool inputs_changed_ = false;
+  bool outputs_changed_ = false;
+  std::vector<std::string> prepended_nodes_;
+  std::vector<std::string> appended_nodes_;
+  std::vector<std::string> initializers_;
+};
+
+} // namespace PaddleOCR
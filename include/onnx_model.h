@@ -0,0 +1,194 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <onnxruntime_cxx_api.h>
+
+#include <include/runtime_profile.h>
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace PaddleOCR {
+
+// Owns one onnxruntime session together with everything that does not change
+// between calls: input/output names, declared shapes, the CPU memory info and
+// the input/output tensors. Run() only rebuilds a tensor when its shape
+// changes, so repeated batches of the same geometry do no setup work at all.
+// Outputs are bound with an IoBinding: once the output shapes of an input
+// shape are known, ORT writes straight into buffers owned by this class and
+// OutputData() points into them, so callers can read results in place.
+class OnnxModel {
+public:
+  OnnxModel() = default;
+  // A copy shares the session of `other` and its loading: copying a lazy
+  // model does not load it, whichever copy needs it first loads it for all.
+  // Each copy has its own buffers and binding, so all can Run() at once.
+  OnnxModel(const OnnxModel &other);
+  OnnxModel &operator=(const OnnxModel &) = delete;
+
+  // Configure the process-wide environment every model attaches to. With
+  // `profile.global_thread_pool` all sessions share one intra-op and one
+  // inter-op pool sized (and spinning) as in `profile` instead of each
+  // creating its own. Only the first call has an effect, later calls (and
+  // SharedEnv() without a prior call) keep whatever is already set up.
+  static void InitEnv(const RuntimeProfile &profile);
+  static Ort::Env &SharedEnv();
+  static bool UseGlobalThreadPool();
+
+  // Create the session from `model_file` and resolve names and shapes.
+  // Depending on `profile.load_mode` this happens right here ("serial"), on a
+  // background thread so several models load at once ("parallel"), or on the
+  // first InputData()/Run() ("lazy"). Either way every other method waits
+  // until the session exists.
+  void LoadModel(const std::string &model_file, const std::string &log_id,
+                 const RuntimeProfile &profile);
+
+  // Mean/scale the model input is normalized with. With
+  // `profile.fold_normalize` the normalization and the HWC->CHW permute are
+  // folded into the graph on load, see OnnxGraph::FoldInputNormalize. Call
+  // before LoadModel().
+  void SetInputNormalize(const std::vector<float> &mean,
+                         const std::vector<float> &scale, const bool is_scale);
+  // Whether the model takes the uint8 NHWC image, fill ByteInputData() then.
+  bool FoldedNormalize();
+
+  // Allow `profile.argmax_output` to reduce the first output to its argmax
+  // over the last axis on load, see OnnxGraph::ReduceOutputArgmax. Call
+  // before LoadModel().
+  void SetOutputArgmax() { this->state_->argmax_wanted = true; }
+  // Whether outputs 0 and 1 are the argmax and max instead of the scores.
+  bool ArgmaxOutput();
+
+  // Have the model also output its probability map thresholded at `thresh`
+  // as a uint8 bitmap, and with `quantize` the map itself as uint8, see
+  // OnnxGraph::ThresholdOutputMap. Call before LoadModel().
+  void SetOutputBitmap(float thresh, bool quantize);
+  // Whether output 1 is the bitmap, read it with ByteOutputData(1).
+  bool OutputBitmap();
+
+  // Block until the session is created, loading it now if it is lazy.
+  void EnsureLoaded();
+  bool IsLoaded() const { return this->state_->loaded; }
+
+  // Return a buffer large enough for a float tensor of `shape`. The buffer is
+  // reused between calls and only grows.
+  float *InputData(const std::vector<int64_t> &shape);
+  uint8_t *ByteInputData(const std::vector<int64_t> &shape);
+
+  void Run();
+
+  size_t OutputCount() const { return this->output_names_ptr_.size(); }
+
+  // Valid until the next Run(), read it in place rather than copying.
+  const float *OutputData(size_t index = 0) const;
+  // Same for uint8 outputs.
+  const uint8_t *ByteOutputData(size_t index = 0) const;
+  const std::vector<int64_t> &OutputShape(size_t index = 0) const;
+  int64_t OutputSize(size_t index = 0) const;
+
+  // Milliseconds spent creating the session, and whether it hit the graph
+  // cache. Both are only meaningful once IsLoaded().
+  double LoadTime() const {
+    return this->IsLoaded() ? this->state_->load_time : 0;
+  }
+  bool CacheHit() const { return this->IsLoaded() && this->state_->cache_hit; }
+
+  // Declared model dims, -1 for dynamic axes.
+  const std::vector<int64_t> &InputDims(size_t index = 0) {
+    this->EnsureLoaded();
+    return this->state_->input_dims[index];
+  }
+
+private:
+  // The session, what it was loaded from and what is known about it, shared
+  // by a model and all its copies.
+  struct SharedState {
+    std::string model_file;
+    std::string log_id;
+    RuntimeProfile profile;
+    std::vector<float> normalize_mean;
+    std::vector<float> normalize_scale;
+    bool normalize_is_scale = true;
+    bool argmax_wanted = false;
+    float bitmap_thresh = -1;
+    bool bitmap_quantize = false;
+
+    Ort::SessionOptions session_options;
+    std::unique_ptr<Ort::Session> session;
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+    std::vector<std::vector<int64_t>> input_dims;
+    std::vector<ONNXTensorElementDataType> output_types;
+    bool folded_normalize = false;
+    bool argmax_output = false;
+    bool output_bitmap = false;
+    double load_time = 0;
+    bool cache_hit = false;
+
+    std::atomic<bool> loaded{false};
+    std::once_flag load_once;
+    // declared last so that a pending load finishes before anything it
+    // writes to is destroyed
+    std::future<void> loading;
+  };
+
+  static void CreateSession(SharedState &state);
+  // Run with outputs allocated by ORT, to learn the output shapes.
+  void RunAllocated();
+
+  // Input buffer of InputData()/ByteInputData(), see there.
+  template <class T>
+  T *InputBuffer(const std::vector<int64_t> &shape, std::vector<T> &buffer);
+
+  // File the optimized graph of `model_data` is cached in under `profile`.
+  static std::string CachePath(const std::string &model_file,
+                               const std::string &model_data,
+                               const RuntimeProfile &profile);
+
+  std::shared_ptr<SharedState> state_ = std::make_shared<SharedState>();
+
+  // set up on the first use of this copy, see EnsureLoaded()
+  Ort::MemoryInfo memory_info_{nullptr};
+  std::vector<const char *> input_names_ptr_;
+  std::vector<const char *> output_names_ptr_;
+
+  // reusable input tensor
+  std::vector<float> input_data_;
+  std::vector<uint8_t> input_bytes_;
+  std::vector<int64_t> input_shape_;
+  Ort::Value input_tensor_{nullptr};
+
+  // outputs of the last run; while `bound_shape_` is the input shape they
+  // wrap `output_data_` and stay bound to `binding_` (uint8 outputs use the
+  // same float buffers, four values per float)
+  Ort::IoBinding binding_{nullptr};
+  std::vector<Ort::Value> output_tensors_;
+  std::vector<std::vector<int64_t>> output_shapes_;
+  std::vector<std::vector<float>> output_data_;
+  std::vector<int64_t> bound_shape_;
+  // output shapes seen for each input shape; disabled for models whose
+  // output shapes depend on the data
+  std::map<std::vector<int64_t>, std::vector<std::vector<int64_t>>>
+      output_shape_cache_;
+  bool dynamic_outputs_ = false;
+};
+
+} // namespace PaddleOCR
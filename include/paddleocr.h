@@ -18,6 +18,10 @@
 #include <include/ocr_det.h>
 #include <include/ocr_rec.h>
 
+#include <chrono>
+#include <map>
+#include <mutex>
+
 namespace PaddleOCR {
 
 class PPOCR {
@@ -39,17 +43,76 @@ protected:
   std::vector<double> time_info_det = {0, 0, 0};
   std::vector<double> time_info_rec = {0, 0, 0};
   std::vector<double> time_info_cls = {0, 0, 0};
+  // when construction started and how long until the first result was
+  // ready, in ms; both kept across reset_timer()
+  std::chrono::steady_clock::time_point time_start;
+  double time_to_first_result = -1;
+
+  void first_result();
+  // print load time of every model in `load_times` and the startup metrics
+  void load_log(const std::map<std::string, double> &load_times);
+  std::map<std::string, double> load_times();
 
-  void det(cv::Mat img, std::vector<OCRPredictResult> &ocr_results);
+  // `worker` picks the models of a page worker, see ocr(img_list)
+  void det(cv::Mat img, std::vector<OCRPredictResult> &ocr_results,
+           size_t worker = 0);
   void rec(std::vector<cv::Mat> img_list,
-           std::vector<OCRPredictResult> &ocr_results);
+           std::vector<OCRPredictResult> &ocr_results, size_t worker = 0);
   void cls(std::vector<cv::Mat> img_list,
-           std::vector<OCRPredictResult> &ocr_results);
+           std::vector<OCRPredictResult> &ocr_results, size_t worker = 0);
 
 private:
   DBDetector *detector_ = nullptr;
   Classifier *classifier_ = nullptr;
   CRNNRecognizer *recognizer_ = nullptr;
+
+  // Models of one page worker. Worker 0 uses the models above, the others
+  // copies of them, which share the onnxruntime sessions but not buffers.
+  struct Worker {
+    DBDetector *detector = nullptr;
+    Classifier *classifier = nullptr;
+    CRNNRecognizer *recognizer = nullptr;
+  };
+  std::vector<Worker> workers_;
+  // guards the timers and first result while workers run
+  std::mutex timer_mutex_;
+
+  // Make sure there are `num` workers, each with a recognizer and, where
+  // `det` and `cls` say so, a detector and classifier.
+  void add_workers(size_t num, bool det = true, bool cls = true);
+  // batch shapes and padding of all recognizers
+  void rec_batch_log();
+  std::vector<OCRPredictResult> ocr_page(cv::Mat img, bool rec, bool cls,
+                                         size_t worker);
+  // cls of the crops of one page; with --cls_vote_samples only a sample of
+  // them, whose vote decides the orientation of all
+  void cls_page(const std::vector<cv::Mat> &crops,
+                std::vector<OCRPredictResult> &results, size_t worker);
+  // With --cls_after_rec_thresh: classify the lines of a recognized page
+  // that scored below it, turn and recognize again those cls finds upside
+  // down, and keep the better of both results.
+  void cls_low_scores(const cv::Mat &img, const std::vector<cv::Mat> &crops,
+                      std::vector<OCRPredictResult> &results, size_t worker);
+  // crops of the result boxes of `img`, appended to `crops`, and the crop
+  // of `result` turned by 180 degrees, see --rec_direct_crop
+  void crop_boxes(const cv::Mat &img,
+                  const std::vector<OCRPredictResult> &results,
+                  std::vector<cv::Mat> &crops);
+  void turn_crop(const cv::Mat &img, const OCRPredictResult &result,
+                 cv::Mat &crop);
+  // det, crop and cls of one page, the (rotated) crops are appended to
+  // `img_list` in the order of the returned results
+  std::vector<OCRPredictResult> det_page(const cv::Mat &img, bool cls,
+                                         size_t worker,
+                                         std::vector<cv::Mat> &img_list);
+  // pages [begin, end) with the crops of all of them recognized together
+  void ocr_pages(const std::vector<cv::Mat> &img_list, size_t begin,
+                 size_t end, bool rec, bool cls, size_t worker,
+                 std::vector<std::vector<OCRPredictResult>> &ocr_results);
+  // det, crop, cls and rec of all pages as stages connected by bounded
+  // queues, each stage on its own thread(s)
+  std::vector<std::vector<OCRPredictResult>>
+  ocr_pipeline(const std::vector<cv::Mat> &img_list, bool rec, bool cls);
 };
 
 } // namespace PaddleOCR
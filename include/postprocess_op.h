@@ -21,38 +21,57 @@ namespace PaddleOCR {
 
 class DBPostProcessor {
 public:
-  void GetContourArea(const std::vector<std::vector<float>> &box,
-                      float unclip_ratio, float &distance);
+  void GetContourArea(const QuadF &box, float unclip_ratio, float &distance);
 
-  cv::RotatedRect UnClip(std::vector<std::vector<float>> box,
-                         const float &unclip_ratio);
+  // Grow `box` by area * unclip_ratio / perimeter on every side and return
+  // the min area rect of the result. Rectangles, what BoxesFromBitmap
+  // passes, are grown in closed form, other quads go to UnClipPolygon.
+  cv::RotatedRect UnClip(const QuadF &box, const float &unclip_ratio);
+  // The same with a ClipperLib round offset, for any polygon.
+  cv::RotatedRect UnClipPolygon(const QuadF &box, const float &unclip_ratio);
 
   float **Mat2Vec(cv::Mat mat);
 
-  std::vector<std::vector<int>>
-  OrderPointsClockwise(std::vector<std::vector<int>> pts);
+  Quad OrderPointsClockwise(const Quad &pts);
 
-  std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box,
-                                               float &ssid);
+  QuadF GetMiniBoxes(cv::RotatedRect box, float &ssid);
 
-  float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred);
-  float PolygonScoreAcc(std::vector<cv::Point> contour, cv::Mat pred);
+  float BoxScoreFast(const QuadF &box_array, const cv::Mat &pred);
+  float PolygonScoreAcc(const std::vector<cv::Point> &contour,
+                        const cv::Mat &pred);
 
-  std::vector<std::vector<std::vector<int>>>
-  BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
-                  const float &box_thresh, const float &det_db_unclip_ratio,
-                  const std::string &det_db_score_mode);
+  // Mean of `pred` (CV_32F, or CV_8U holding probability * 255) over the
+  // pixels fillPoly sets for the polygon, summed span by span in place
+  // without allocating. Exact for contours, whose edges are horizontal,
+  // vertical or diagonal; along other edges fillPoly covers a bit more.
+  // The overload taking the RowSums() of `pred` costs O(1) per span, which
+  // pays off when many polygons are scored on a map.
+  float PolygonScore(const cv::Point *pts, int n, const cv::Mat &pred);
+  float PolygonScore(const cv::Point *pts, int n, const cv::Mat &pred,
+                     const cv::Mat &sums);
+  static void RowSums(const cv::Mat &pred, cv::Mat &sums);
+  // The same through a fillPoly mask, used for polygons the span walk
+  // does not handle (zero area or very many crossings in one row).
+  float MaskScore(const cv::Point *pts, int n, const cv::Mat &pred);
 
-  std::vector<std::vector<std::vector<int>>>
-  FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes,
-                  float ratio_h, float ratio_w, cv::Mat srcimg);
+  std::vector<Quad> BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
+                                    const float &box_thresh,
+                                    const float &det_db_unclip_ratio,
+                                    const std::string &det_db_score_mode);
 
-private:
-  static bool XsortInt(std::vector<int> a, std::vector<int> b);
-
-  static bool XsortFp32(std::vector<float> a, std::vector<float> b);
+  std::vector<Quad> FilterTagDetRes(std::vector<Quad> boxes, float ratio_h,
+                                    float ratio_w, cv::Mat srcimg);
 
-  std::vector<std::vector<float>> Mat2Vector(cv::Mat mat);
+private:
+  // Box of one contour in `pred` coordinates, false if it is too small or
+  // scores below `box_thresh`. Thread safe, BoxesFromBitmap runs it for
+  // many contours at once.
+  bool BoxFromContour(const std::vector<cv::Point> &contour,
+                      const cv::Mat &pred, int width, int height,
+                      const float &box_thresh,
+                      const float &det_db_unclip_ratio,
+                      const std::string &det_db_score_mode,
+                      Quad &box_out);
 
   inline int _max(int a, int b) { return a >= b ? a : b; }
 
@@ -40,11 +40,46 @@ public:
   virtual void Run(const std::vector<cv::Mat> imgs, float *data);
 };
 
+// Copy uint8 HWC images into the h x w slots of an NHWC batch, filling what
+// an image does not cover with `pad`. Input of models with folded
+// normalization, see OnnxModel::SetInputNormalize.
+class PackBatch {
+public:
+  virtual void Run(const std::vector<cv::Mat> &imgs, const int h, const int w,
+                   const cv::Scalar &pad, uint8_t *data);
+};
+
 class ResizeImgType0 {
 public:
   virtual void Run(const cv::Mat &img, cv::Mat &resize_img,
                    std::string limit_type, int limit_side_len, float &ratio_h,
                    float &ratio_w, bool use_tensorrt);
+
+  // Size Run() resizes `img` to, a multiple of 32 on both sides.
+  cv::Size TargetSize(const cv::Mat &img, const std::string &limit_type,
+                      int limit_side_len);
+};
+
+// Bilinear resize of a BGR uint8 image fused with Normalize and Permute: each
+// output row is interpolated from at most two source rows and written,
+// normalized, straight into the planar CHW float buffer `data`. One pass over
+// the image and no intermediate float images, instead of the six passes of
+// ResizeImgType0 + Normalize + Permute. Matches them up to the uchar
+// rounding cv::resize applies before normalizing.
+class ResizeNormalizePermute {
+public:
+  virtual void Run(const cv::Mat &img, const cv::Size &size,
+                   const std::vector<float> &mean,
+                   const std::vector<float> &scale, const bool is_scale,
+                   float *data);
+
+private:
+  // horizontal taps of every output column, in elements of the source row
+  std::vector<int> xofs0_;
+  std::vector<int> xofs1_;
+  std::vector<float> xalpha_;
+  // two horizontally resized source rows, planar
+  std::vector<float> rows_;
 };
 
 class CrnnResizeImg {
@@ -52,6 +87,10 @@ public:
   virtual void Run(const cv::Mat &img, cv::Mat &resize_img, float wh_ratio,
                    bool use_tensorrt = false,
                    const std::vector<int> &rec_image_shape = {3, 32, 320});
+
+  // Width Run() resizes `img` to, before padding.
+  int ResizeWidth(const cv::Mat &img, float wh_ratio,
+                  const std::vector<int> &rec_image_shape);
 };
 
 class ClsResizeImg {
@@ -59,6 +98,27 @@ public:
   virtual void Run(const cv::Mat &img, cv::Mat &resize_img,
                    bool use_tensorrt = false,
                    const std::vector<int> &rec_image_shape = {3, 48, 192});
+
+  // Width Run() resizes `img` to.
+  int ResizeWidth(const cv::Mat &img, const std::vector<int> &rec_image_shape);
+};
+
+// Fills one slot of an NCHW rec/cls batch in place: `img` is resized to
+// `resize_size` into a reused buffer, and only those columns are normalized
+// into `data`. The rest of the slot up to `batch_w` is padding. With
+// `normalize_pad` it gets the normalized value of a black pixel, as if the
+// crop had been padded before Normalize (rec). Otherwise it gets 0, as if
+// padded after Normalize (cls). This replaces the per-crop copy, resize,
+// copyMakeBorder, Normalize and PermuteBatch.
+class ResizeNormalizeBatch {
+public:
+  virtual void Run(const cv::Mat &img, const cv::Size &resize_size,
+                   const int batch_w, const std::vector<float> &mean,
+                   const std::vector<float> &scale, const bool is_scale,
+                   const bool normalize_pad, float *data);
+
+private:
+  std::vector<uchar> resize_data_;
 };
 
 class TableResizeImg {
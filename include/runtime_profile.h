@@ -0,0 +1,75 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <onnxruntime_cxx_api.h>
+
+#include <string>
+
+namespace PaddleOCR {
+
+// CPU runtime settings of one onnxruntime session. A profile starts from the
+// global flags, is refined by --runtime_config and finally by the per-model
+// --<model>_runtime_options string, all using the same "key=value" syntax:
+//
+//   preset                   latency | throughput
+//   intra_op_threads         threads inside one operator
+//   inter_op_threads         threads running independent operators
+//   execution_mode           sequential | parallel
+//   graph_optimization_level disable | basic | extended | all
+//   enable_mem_pattern       true | false
+//   enable_cpu_mem_arena     true | false
+//   allow_spinning           true | false, busy-wait of idle pool threads
+//   global_thread_pool       true | false, use the process-wide pool
+//   model_cache              true | false, reuse the optimized graph
+//   model_cache_dir          where cached graphs go, default next to model
+//   model_cache_format       onnx | ort
+//   load_mode                serial | parallel | lazy, see OnnxModel
+//   fold_normalize           true | false, feed uint8 NHWC images
+//   argmax_output            true | false, argmax of the scores in the graph
+struct RuntimeProfile {
+  int intra_op_threads = 1;
+  int inter_op_threads = 1;
+  bool parallel_execution = false;
+  std::string graph_optimization_level = "all";
+  bool enable_mem_pattern = true;
+  bool enable_cpu_mem_arena = true;
+  bool allow_spinning = true;
+  bool global_thread_pool = true;
+  bool use_mkldnn = false;
+  bool model_cache = false;
+  std::string model_cache_dir;
+  std::string model_cache_format = "onnx";
+  std::string load_mode = "parallel";
+  bool fold_normalize = false;
+  bool argmax_output = false;
+
+  // Apply one "key=value" setting, exit on unknown keys or values.
+  void Set(const std::string &key, const std::string &value);
+  // Apply a comma separated list of "key=value" settings.
+  void Parse(const std::string &options);
+
+  // Set up `session_options`; true if an execution provider other than the
+  // default CPU one was added (its compiled nodes cannot be saved).
+  bool Apply(Ort::SessionOptions &session_options) const;
+
+  std::string ToString() const;
+
+  // Build the profile of `model_name` (det, cls, rec, table, layout) from the
+  // command line flags and the optional runtime config file.
+  static RuntimeProfile FromFlags(const std::string &model_name);
+};
+
+} // namespace PaddleOCR
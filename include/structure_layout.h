@@ -14,8 +14,7 @@
 
 #pragma once
 
-#include <onnxruntime_cxx_api.h>
-
+#include <include/onnx_model.h>
 #include <include/postprocess_op.h>
 #include <include/preprocess_op.h>
 
@@ -29,12 +28,14 @@ public:
       const bool &use_mkldnn, const std::string &label_path,
       const bool &use_tensorrt, const std::string &precision,
       const double &layout_score_threshold,
-      const double &layout_nms_threshold) {
+      const double &layout_nms_threshold,
+      const RuntimeProfile &runtime_profile) {
     this->use_gpu_ = use_gpu;
     this->gpu_id_ = gpu_id;
     this->gpu_mem_ = gpu_mem;
     this->cpu_math_library_num_threads_ = cpu_math_library_num_threads;
     this->use_mkldnn_ = use_mkldnn;
+    this->runtime_profile_ = runtime_profile;
     this->use_tensorrt_ = use_tensorrt;
     this->precision_ = precision;
 
@@ -45,15 +46,16 @@ public:
 
   // Load Paddle inference model
   void LoadModel(const std::string &model_dir);
+  // ms spent loading the model, 0 until it is loaded
+  double LoadTime() const { return this->model_.LoadTime(); }
 
   void Run(cv::Mat img, std::vector<StructurePredictResult> &result,
            std::vector<double> &times);
 
 private:
   // std::shared_ptr<paddle_infer::Predictor> predictor_;
-  Ort::Session *session;
-  Ort::Env env = Ort::Env(ORT_LOGGING_LEVEL_ERROR, "structure_layout");
-  Ort::SessionOptions sessionOptions = Ort::SessionOptions();
+  OnnxModel model_;
+  RuntimeProfile runtime_profile_;
 
   bool use_gpu_ = false;
   int gpu_id_ = 0;
@@ -32,6 +32,21 @@
 
 namespace PaddleOCR {
 
+// The four corners of a text box, top-left first and clockwise once
+// ordered, as a flat fixed-size struct: det postprocessing, sorting and
+// cropping pass these by value without allocating. `quad[i][0]` and
+// `quad[i][1]` are x and y of corner i, as with the nested vectors of
+// OCRPredictResult::box that results are handed out in.
+template <class T> struct QuadT {
+  T pts[4][2];
+
+  T *operator[](int i) { return this->pts[i]; }
+  const T *operator[](int i) const { return this->pts[i]; }
+  static int size() { return 4; }
+};
+typedef QuadT<int> Quad;
+typedef QuadT<float> QuadF;
+
 struct OCRPredictResult {
   std::vector<std::vector<int>> box;
   std::string text;
@@ -67,11 +82,35 @@ public:
     return std::distance(first, std::max_element(first, last));
   }
 
+  // Index of the largest of the `n` (> 0) values at `data`, the first one on
+  // ties, and that value in `max_value`. One vectorized pass, unlike
+  // argmax() followed by max_element().
+  static int ArgmaxValue(const float *data, int n, float &max_value);
+
   static void GetAllFiles(const char *dir_name,
                           std::vector<std::string> &all_inputs);
 
+  // Crop of `box` warped upright (and turned if it stands vertically). The
+  // warp reads from a view of `srcimage`, and the crop of an axis-aligned
+  // box is a view into `srcimage` itself: clone it before writing to it.
+  static cv::Mat GetRotateCropImage(const cv::Mat &srcimage, const Quad &box);
+  // The same crop resampled from `srcimage` in one warp: resized to
+  // `height` rows with the width rec and cls would give it (kept as it is
+  // for 0), and with `flip` turned by 180 degrees.
+  static cv::Mat GetRotateCropImage(const cv::Mat &srcimage, const Quad &box,
+                                    int height, bool flip);
   static cv::Mat GetRotateCropImage(const cv::Mat &srcimage,
-                                    std::vector<std::vector<int>> box);
+                                    const std::vector<std::vector<int>> &box);
+
+  // Append the crops of every result box to `crops`, in parallel, each
+  // `height` rows high as above.
+  static void GetRotateCropImages(const cv::Mat &srcimage,
+                                  const std::vector<OCRPredictResult> &results,
+                                  std::vector<cv::Mat> &crops, int height = 0);
+
+  // Between a Quad and the nested vectors of OCRPredictResult::box.
+  static std::vector<std::vector<int>> QuadToBox(const Quad &quad);
+  static Quad BoxToQuad(const std::vector<std::vector<int>> &box);
 
   static std::vector<int> argsort(const std::vector<float> &array);
 
@@ -87,27 +126,22 @@ public:
   static cv::Mat crop_image(cv::Mat &img, const std::vector<float> &area);
 
   static void sorted_boxes(std::vector<OCRPredictResult> &ocr_result);
+  static void sorted_boxes(std::vector<Quad> &boxes);
 
+  static std::vector<int> xyxyxyxy2xyxy(const Quad &box);
   static std::vector<int> xyxyxyxy2xyxy(std::vector<std::vector<int>> &box);
   static std::vector<int> xyxyxyxy2xyxy(std::vector<int> &box);
 
+  // uint8 value per channel that (x * e - mean) * scale maps to about 0, to
+  // pad images whose normalization is folded into the model
+  static cv::Scalar NormalizedZero(const std::vector<float> &mean,
+                                   const bool is_scale);
+
   static float fast_exp(float x);
   static std::vector<float>
   activation_function_softmax(std::vector<float> &src);
   static float iou(std::vector<int> &box1, std::vector<int> &box2);
   static float iou(std::vector<float> &box1, std::vector<float> &box2);
-
-private:
-  static bool comparison_box(const OCRPredictResult &result1,
-                             const OCRPredictResult &result2) {
-    if (result1.box[0][1] < result2.box[0][1]) {
-      return true;
-    } else if (result1.box[0][1] == result2.box[0][1]) {
-      return result1.box[0][0] < result2.box[0][0];
-    } else {
-      return false;
-    }
-  }
 };
 
 } // namespace PaddleOCR
\ No newline at end of file
@@ -20,6 +20,52 @@ DEFINE_bool(use_tensorrt, false, "Whether use tensorrt.");
 DEFINE_int32(gpu_id, 0, "Device id of GPU to execute.");
 DEFINE_int32(gpu_mem, 4000, "GPU id when infering with GPU.");
 DEFINE_int32(cpu_threads, 10, "Num of threads with CPU.");
+DEFINE_bool(use_global_thread_pool, true,
+            "Whether all models share one onnxruntime thread pool.");
+DEFINE_string(runtime_profile, "",
+              "Runtime preset of all models, latency or throughput.");
+DEFINE_int32(intra_op_threads, 0,
+             "Threads inside one operator, defaults to cpu_threads.");
+DEFINE_int32(inter_op_threads, 1,
+             "Threads running independent operators in parallel mode.");
+DEFINE_string(execution_mode, "sequential",
+              "Operator execution mode, sequential or parallel.");
+DEFINE_string(graph_optimization_level, "all",
+              "Graph optimization level, disable/basic/extended/all.");
+DEFINE_bool(enable_mem_pattern, true, "Whether use memory pattern planning.");
+DEFINE_bool(enable_cpu_mem_arena, true, "Whether use the CPU memory arena.");
+DEFINE_bool(allow_spinning, true,
+            "Whether idle onnxruntime threads busy-wait for work.");
+DEFINE_string(runtime_config, "",
+              "Path of a runtime config file with key=value lines, keys may "
+              "be prefixed with det./cls./rec./table./layout.");
+DEFINE_string(det_runtime_options, "",
+              "Runtime options of det, e.g. intra_op_threads=4,"
+              "allow_spinning=false.");
+DEFINE_string(cls_runtime_options, "", "Runtime options of cls.");
+DEFINE_string(rec_runtime_options, "", "Runtime options of rec.");
+DEFINE_string(table_runtime_options, "", "Runtime options of table.");
+DEFINE_string(layout_runtime_options, "", "Runtime options of layout.");
+DEFINE_bool(model_cache, false,
+            "Whether cache optimized models to speed up later starts.");
+DEFINE_string(model_cache_dir, "",
+              "Dir of cached optimized models, defaults to each model dir.");
+DEFINE_string(model_cache_format, "onnx",
+              "Format of cached optimized models, onnx or ort.");
+DEFINE_string(model_load_mode, "parallel",
+              "How models are loaded: serial, parallel or lazy.");
+DEFINE_bool(fold_normalize, false,
+            "Whether fold input normalization into the models on load.");
+DEFINE_bool(argmax_output, false,
+            "Whether take the argmax of the rec scores inside the model.");
+DEFINE_int32(page_workers, 1,
+             "Num of pages run through det/cls/rec concurrently in ocr mode.");
+DEFINE_int32(rec_pool_pages, 1,
+             "Num of pages whose crops are recognized in the same batches.");
+DEFINE_bool(pipeline, false,
+            "Whether run det, crop, cls and rec as pipelined stages.");
+DEFINE_int32(pipeline_queue_size, 4, "Max pages waiting between stages.");
+DEFINE_int32(pipeline_rec_workers, 1, "Num of threads of the rec stage.");
 DEFINE_bool(enable_mkldnn, false, "Whether use mkldnn with CPU.");
 DEFINE_string(precision, "fp32", "Precision be one of fp32/fp16/int8");
 DEFINE_bool(benchmark, false, "Whether use benchmark.");
@@ -36,6 +82,10 @@ DEFINE_double(det_db_thresh, 0.3, "Threshold of det_db_thresh.");
 DEFINE_double(det_db_box_thresh, 0.6, "Threshold of det_db_box_thresh.");
 DEFINE_double(det_db_unclip_ratio, 1.5, "Threshold of det_db_unclip_ratio.");
 DEFINE_bool(use_dilation, false, "Whether use the dilation on output map.");
+DEFINE_bool(det_fused_preprocess, true,
+            "Whether resize, normalize and permute det input in one pass.");
+DEFINE_string(det_map_output, "float",
+              "What the det model outputs: float, bitmap or uint8.");
 DEFINE_string(det_db_score_mode, "slow", "Whether use polygon score.");
 DEFINE_bool(visualize, true, "Whether show the detection results.");
 // classification related
@@ -43,13 +93,34 @@ DEFINE_bool(use_angle_cls, false, "Whether use use_angle_cls.");
 DEFINE_string(cls_model_dir, "", "Path of cls inference model.");
 DEFINE_double(cls_thresh, 0.9, "Threshold of cls_thresh.");
 DEFINE_int32(cls_batch_num, 1, "cls_batch_num.");
+DEFINE_int32(cls_vote_samples, 0,
+             "Classify this many lines of a page and turn all of them by "
+             "the vote, 0 to classify every line.");
+DEFINE_double(cls_vote_margin, 0.8,
+              "Share of the score-weighted vote an orientation needs, "
+              "otherwise every line is classified.");
+DEFINE_double(cls_after_rec_thresh, 0,
+              "Run rec before cls and classify only lines whose rec score "
+              "is below this, 0 to run cls first.");
 // recognition related
 DEFINE_string(rec_model_dir, "", "Path of rec inference model.");
 DEFINE_int32(rec_batch_num, 6, "rec_batch_num.");
+DEFINE_int32(rec_batch_width, 0,
+             "Max padded width summed over a rec batch, 0 to use "
+             "rec_batch_num.");
+DEFINE_double(rec_max_pad_ratio, 0.5,
+              "Max share of padding in a rec batch with rec_batch_width.");
+DEFINE_double(rec_max_wh_ratio, 0,
+              "Split crops wider than this times their height, 0 to never.");
+DEFINE_double(rec_chunk_overlap, 2,
+              "Overlap of split crops, in multiples of the crop height.");
 DEFINE_string(rec_char_dict_path, "ppocr/utils/ppocr_keys_v1.txt",
               "Path of dictionary.");
 DEFINE_int32(rec_img_h, 48, "rec image height");
 DEFINE_int32(rec_img_w, 320, "rec image width");
+DEFINE_bool(rec_direct_crop, false,
+            "Warp text boxes straight to the rec image height, turning "
+            "them for cls in the same warp.");
 
 // layout model related
 DEFINE_string(layout_model_dir, "", "Path of table layout inference model.");
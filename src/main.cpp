@@ -71,7 +71,7 @@ void check_params() {
 
 void ocr(std::vector<cv::String> &cv_all_img_names) {
   // init ocr object
-  PPOCR ocr = PPOCR();
+  PPOCR ocr;
 
   if (FLAGS_benchmark) {
     ocr.reset_timer();
@@ -90,8 +90,11 @@ void ocr(std::vector<cv::String> &cv_all_img_names) {
     img_names.push_back(cv_all_img_names[i]);
   }
 
+  auto ocr_start = std::chrono::steady_clock::now();
   std::vector<std::vector<OCRPredictResult>> ocr_results =
       ocr.ocr(img_list, FLAGS_det, FLAGS_rec, FLAGS_cls);
+  std::chrono::duration<float> ocr_diff =
+      std::chrono::steady_clock::now() - ocr_start;
 
   for (int i = 0; i < img_names.size(); ++i) {
     std::cout << "predict img: " << cv_all_img_names[i] << std::endl;
@@ -105,16 +108,21 @@ void ocr(std::vector<cv::String> &cv_all_img_names) {
   }
   if (FLAGS_benchmark) {
     ocr.benchmark_log(cv_all_img_names.size());
+    std::cout << "throughput: " << img_list.size() / ocr_diff.count()
+              << " img/s" << std::endl;
   }
 }
 
 void structure(std::vector<cv::String> &cv_all_img_names) {
-  PaddleOCR::PaddleStructure engine = PaddleOCR::PaddleStructure();
+  PaddleOCR::PaddleStructure engine;
 
   if (FLAGS_benchmark) {
     engine.reset_timer();
   }
 
+  std::chrono::duration<float> structure_diff =
+      std::chrono::steady_clock::now() - std::chrono::steady_clock::now();
+  int img_num = 0;
   for (int i = 0; i < cv_all_img_names.size(); i++) {
     std::cout << "predict img: " << cv_all_img_names[i] << std::endl;
     cv::Mat img = cv::imread(cv_all_img_names[i], cv::IMREAD_COLOR);
@@ -124,8 +132,11 @@ void structure(std::vector<cv::String> &cv_all_img_names) {
       continue;
     }
 
+    auto structure_start = std::chrono::steady_clock::now();
     std::vector<StructurePredictResult> structure_results = engine.structure(
         img, FLAGS_layout, FLAGS_table, FLAGS_det && FLAGS_rec);
+    structure_diff += std::chrono::steady_clock::now() - structure_start;
+    img_num++;
 
     for (int j = 0; j < structure_results.size(); j++) {
       std::cout << j << "\ttype: " << structure_results[j].type
@@ -160,6 +171,8 @@ void structure(std::vector<cv::String> &cv_all_img_names) {
   }
   if (FLAGS_benchmark) {
     engine.benchmark_log(cv_all_img_names.size());
+    std::cout << "throughput: " << img_num / structure_diff.count()
+              << " img/s" << std::endl;
   }
 }
 
@@ -36,78 +36,52 @@ void Classifier::Run(std::vector<cv::Mat> img_list,
     int batch_num = end_img_no - beg_img_no;
 
     // preprocess
-    std::vector<cv::Mat> norm_img_batch;
-    for (int ino = beg_img_no; ino < end_img_no; ino++) {
-      cv::Mat srcimg;
-      img_list[ino].copyTo(srcimg);
-      cv::Mat resize_img;
-      this->resize_op_.Run(srcimg, resize_img, this->use_tensorrt_,
-                           cls_image_shape);
-
-      this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                              this->is_scale_);
-      if (resize_img.cols < cls_image_shape[2]) {
-        cv::copyMakeBorder(resize_img, resize_img, 0, 0, 0,
-                           cls_image_shape[2] - resize_img.cols,
-                           cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+    if (this->model_.FoldedNormalize()) {
+      std::vector<cv::Mat> norm_img_batch;
+      for (int ino = beg_img_no; ino < end_img_no; ino++) {
+        const cv::Mat &img = img_list[ino];
+        if (img.rows == cls_image_shape[1] &&
+            img.cols <= cls_image_shape[2]) {
+          // a rec height crop of the same height is used as it is
+          norm_img_batch.push_back(img);
+          continue;
+        }
+        cv::Mat resize_img;
+        this->resize_op_.Run(img, resize_img, this->use_tensorrt_,
+                             cls_image_shape);
+        norm_img_batch.push_back(resize_img);
+      }
+      uint8_t *input = this->model_.ByteInputData(
+          {batch_num, cls_image_shape[1], cls_image_shape[2],
+           cls_image_shape[0]});
+      this->pack_op_.Run(norm_img_batch, cls_image_shape[1],
+                         cls_image_shape[2],
+                         Utility::NormalizedZero(this->mean_, this->is_scale_),
+                         input);
+    } else {
+      float *input = this->model_.InputData(
+          {batch_num, cls_image_shape[0], cls_image_shape[1],
+           cls_image_shape[2]});
+      const int slot = cls_image_shape[0] * cls_image_shape[1] *
+                       cls_image_shape[2];
+      for (int ino = beg_img_no; ino < end_img_no; ino++) {
+        int resize_w =
+            this->resize_op_.ResizeWidth(img_list[ino], cls_image_shape);
+        this->batch_op_.Run(img_list[ino],
+                            cv::Size(resize_w, cls_image_shape[1]),
+                            cls_image_shape[2], this->mean_, this->scale_,
+                            this->is_scale_, false,
+                            input + size_t(ino - beg_img_no) * slot);
       }
-      norm_img_batch.push_back(resize_img);
     }
-    std::vector<float> input(batch_num * cls_image_shape[0] *
-                                 cls_image_shape[1] * cls_image_shape[2],
-                             0.0f);
-    this->permute_op_.Run(norm_img_batch, input.data());
     auto preprocess_end = std::chrono::steady_clock::now();
     preprocess_diff += preprocess_end - preprocess_start;
 
-    // get shape of norm_img_batch
-    std::array<int64_t, 4> input_shape{cls_batch_num_, 3, 48, 192};
-
-    // inference with onnx
-    Ort::AllocatorWithDefaultOptions allocator;
-
-    // get input names ptr
-    const size_t in_num = session->GetInputCount();
-    std::vector<Ort::AllocatedStringPtr> input_names_ptr;
-    input_names_ptr.reserve(in_num);
-    for (size_t i = 0; i < in_num; i++) {
-        auto input_name = session->GetInputNameAllocated(i, allocator);
-        input_names_ptr.push_back(std::move(input_name));
-    }
-
-    // get output name ptr
-    const size_t out_num = session->GetOutputCount();
-    std::vector<Ort::AllocatedStringPtr> output_names_ptr;
-    output_names_ptr.reserve(out_num);
-    for (size_t i = 0; i < out_num; i++) {
-        auto output_name = session->GetOutputNameAllocated(i, allocator);
-        output_names_ptr.push_back(std::move(output_name));
-    }
-
     // run
     auto inference_start = std::chrono::steady_clock::now();
-
-    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
-    std::vector<const char *> input_names = {input_names_ptr.data()->get()};
-    std::vector<const char *> output_names = {output_names_ptr.data()->get()};
-
-    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info, input.data(),
-                                                              input.size(), input_shape.data(),
-                                                              input_shape.size());
-
-    auto output_tensors = session->Run(Ort::RunOptions{nullptr}, input_names.data(), &input_tensor,
-                                      input_names.size(), output_names.data(), output_names.size());
-    std::vector<int64_t> predict_shape = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
-    // for (size_t j = 0; j < predict_shape.size(); j++) {
-    //         printf("Predicted shape dim[%zu] = %llu\n",j, predict_shape[j]);
-    // }
-    
-    int64_t output_count = std::accumulate(predict_shape.begin(), predict_shape.end(), 1, 
-                                       std::multiplies<int64_t>());
-
-    // output tensor value                                   
-    float *float_array = output_tensors.front().GetTensorMutableData<float>();
-    std::vector<float> predict_batch(float_array, float_array + output_count);
+    this->model_.Run();
+    const std::vector<int64_t> &predict_shape = this->model_.OutputShape();
+    const float *predict_batch = this->model_.OutputData();
 
     auto inference_end = std::chrono::steady_clock::now();
     inference_diff += inference_end - inference_start;
@@ -134,23 +108,9 @@ void Classifier::Run(std::vector<cv::Mat> img_list,
 
 void Classifier::LoadModel(const std::string &model_dir) {
   std::cout << "Load model classification" << std::endl;
-  std::string model_file = model_dir + "/inference.onnx";
-  this->session = new Ort::Session(this->env, model_file.c_str(), this->sessionOptions);
-  
-  const size_t in_num = session->GetInputCount();
-  Ort::AllocatorWithDefaultOptions allocator;
-  for (int i = 0; i < in_num; ++i) {
-    auto name = session->GetInputNameAllocated(i, allocator);
-    std::cout << "Input Name: " << name.get() << std::endl;
-    
-    auto type_info = session->GetInputTypeInfo(i);
-    auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
-    auto input_node_dims = tensor_info.GetShape();
-    printf("Input num_dims = %zu\n", input_node_dims.size());
-    for (size_t j = 0; j < input_node_dims.size(); j++) {
-      printf("Input dim[%zu] = %llu\n",j, input_node_dims[j]);
-    }
-  }
+  this->model_.SetInputNormalize(this->mean_, this->scale_, this->is_scale_);
+  this->model_.LoadModel(model_dir + "/inference.onnx", "ocr_cls",
+                         this->runtime_profile_);
 }
 
 } // namespace PaddleOCR
@@ -14,6 +14,8 @@
 
 #include <include/ocr_rec.h>
 
+#include <limits>
+
 namespace PaddleOCR {
 
 void CRNNRecognizer::Run(std::vector<cv::Mat> img_list,
@@ -27,156 +29,284 @@ void CRNNRecognizer::Run(std::vector<cv::Mat> img_list,
   std::chrono::duration<float> postprocess_diff =
       std::chrono::steady_clock::now() - std::chrono::steady_clock::now();
 
-  int img_num = img_list.size();
+  // over-wide crops are recognized in chunks, batched like any other crop
+  std::vector<cv::Mat> piece_list;
+  std::vector<RecPiece> pieces;
+  this->SplitWide(img_list, piece_list, pieces);
+  std::vector<std::vector<CtcToken>> piece_tokens(piece_list.size());
+
+  int img_num = piece_list.size();
   std::vector<float> width_list;
   for (int i = 0; i < img_num; i++) {
-    width_list.push_back(float(img_list[i].cols) / img_list[i].rows);
+    width_list.push_back(float(piece_list[i].cols) / piece_list[i].rows);
   }
   std::vector<int> indices = Utility::argsort(width_list);
 
-  for (int beg_img_no = 0; beg_img_no < img_num;
-       beg_img_no += this->rec_batch_num_) {
+  for (int beg_img_no = 0, end_img_no = 0; beg_img_no < img_num;
+       beg_img_no = end_img_no) {
     auto preprocess_start = std::chrono::steady_clock::now();
-    int end_img_no = std::min(img_num, beg_img_no + this->rec_batch_num_);
+    end_img_no = this->BatchEnd(width_list, indices, beg_img_no);
     int batch_num = end_img_no - beg_img_no;
     int imgH = this->rec_image_shape_[1];
     int imgW = this->rec_image_shape_[2];
     float max_wh_ratio = imgW * 1.0 / imgH;
     for (int ino = beg_img_no; ino < end_img_no; ino++) {
-      int h = img_list[indices[ino]].rows;
-      int w = img_list[indices[ino]].cols;
+      int h = piece_list[indices[ino]].rows;
+      int w = piece_list[indices[ino]].cols;
       float wh_ratio = w * 1.0 / h;
       max_wh_ratio = std::max(max_wh_ratio, wh_ratio);
     }
 
-    int batch_width = imgW;
-    std::vector<cv::Mat> norm_img_batch;
+    // every crop is padded to the width of the widest one
+    int batch_width = std::max(imgW, int(imgH * max_wh_ratio));
+    std::vector<int> resize_w(batch_num);
     for (int ino = beg_img_no; ino < end_img_no; ino++) {
-      cv::Mat srcimg;
-      img_list[indices[ino]].copyTo(srcimg);
-      cv::Mat resize_img;
-      this->resize_op_.Run(srcimg, resize_img, max_wh_ratio,
-                           this->use_tensorrt_, this->rec_image_shape_);
-      this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                              this->is_scale_);
-      norm_img_batch.push_back(resize_img);
-      batch_width = std::max(resize_img.cols, batch_width);
+      resize_w[ino - beg_img_no] = this->resize_op_.ResizeWidth(
+          piece_list[indices[ino]], max_wh_ratio, this->rec_image_shape_);
     }
-
-    std::vector<float> input(batch_num * 3 * imgH * batch_width, 0.0f);
-    this->permute_op_.Run(norm_img_batch, input.data());
-    auto preprocess_end = std::chrono::steady_clock::now();
-    preprocess_diff += preprocess_end - preprocess_start;
-
-    std::array<int64_t, 4> input_shape{batch_num, 3, imgH, batch_width};
-
-    // inference with onnx
-    Ort::AllocatorWithDefaultOptions allocator;
-
-    // get input names ptr
-    const size_t in_num = session->GetInputCount();
-    std::vector<Ort::AllocatedStringPtr> input_names_ptr;
-    input_names_ptr.reserve(in_num);
-    for (size_t i = 0; i < in_num; i++) {
-        auto input_name = session->GetInputNameAllocated(i, allocator);
-        input_names_ptr.push_back(std::move(input_name));
+    this->batch_stats_.shapes[std::make_pair(batch_num, batch_width)]++;
+    this->batch_stats_.padded_cols += double(batch_num) * batch_width;
+    for (int m = 0; m < batch_num; m++) {
+      this->batch_stats_.valid_cols += resize_w[m];
     }
-
-    // get output name ptr
-    const size_t out_num = session->GetOutputCount();
-    std::vector<Ort::AllocatedStringPtr> output_names_ptr;
-    output_names_ptr.reserve(out_num);
-    for (size_t i = 0; i < out_num; i++) {
-        auto output_name = session->GetOutputNameAllocated(i, allocator);
-        output_names_ptr.push_back(std::move(output_name));
+    if (this->model_.FoldedNormalize()) {
+      std::vector<cv::Mat> norm_img_batch;
+      for (int ino = beg_img_no; ino < end_img_no; ino++) {
+        const cv::Mat &piece = piece_list[indices[ino]];
+        if (piece.rows == imgH && piece.cols == resize_w[ino - beg_img_no]) {
+          // already at the input size, pack_op_ pads it
+          norm_img_batch.push_back(piece);
+          continue;
+        }
+        cv::Mat resize_img;
+        this->resize_op_.Run(piece, resize_img, max_wh_ratio,
+                             this->use_tensorrt_, this->rec_image_shape_);
+        norm_img_batch.push_back(resize_img);
+      }
+      // CrnnResizeImg pads with 0 before normalizing, so pad with 0 here too
+      uint8_t *input =
+          this->model_.ByteInputData({batch_num, imgH, batch_width, 3});
+      this->pack_op_.Run(norm_img_batch, imgH, batch_width,
+                         cv::Scalar(0, 0, 0), input);
+    } else {
+      float *input =
+          this->model_.InputData({batch_num, 3, imgH, batch_width});
+      for (int ino = beg_img_no; ino < end_img_no; ino++) {
+        this->batch_op_.Run(
+            piece_list[indices[ino]],
+            cv::Size(resize_w[ino - beg_img_no], imgH), batch_width,
+            this->mean_, this->scale_, this->is_scale_, true,
+            input + size_t(ino - beg_img_no) * 3 * imgH * batch_width);
+      }
     }
+    auto preprocess_end = std::chrono::steady_clock::now();
+    preprocess_diff += preprocess_end - preprocess_start;
 
     // run
     auto inference_start = std::chrono::steady_clock::now();
-
-    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
-    std::vector<const char *> input_names = {input_names_ptr.data()->get()};
-    std::vector<const char *> output_names = {output_names_ptr.data()->get()};
-
-    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info, input.data(),
-                                                              input.size(), input_shape.data(),
-                                                              input_shape.size());
-
-    auto output_tensors = session->Run(Ort::RunOptions{nullptr}, input_names.data(), &input_tensor,
-                                      input_names.size(), output_names.data(), output_names.size());
-    std::vector<int64_t> predict_shape = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
-    
-    int64_t output_count = std::accumulate(predict_shape.begin(), predict_shape.end(), 1, 
-                                       std::multiplies<int64_t>());
-
-    // output tensor value                                   
-    float *float_array = output_tensors.front().GetTensorMutableData<float>();
-    std::vector<float> predict_batch(float_array, float_array + output_count);
+    this->model_.Run();
+    const std::vector<int64_t> &predict_shape = this->model_.OutputShape();
+    const float *predict_batch = this->model_.OutputData();
 
     auto inference_end = std::chrono::steady_clock::now();
     inference_diff += inference_end - inference_start;
 
     // ctc decode
     auto postprocess_start = std::chrono::steady_clock::now();
-    for (int m = 0; m < predict_shape[0]; m++) {
-      std::string str_res;
-      int argmax_idx;
-      int last_index = 0;
-      float score = 0.f;
-      int count = 0;
-      float max_value = 0.0f;
-
-      for (int n = 0; n < predict_shape[1]; n++) {
-        // get idx
-        argmax_idx = int(Utility::argmax(
-            &predict_batch[(m * predict_shape[1] + n) * predict_shape[2]],
-            &predict_batch[(m * predict_shape[1] + n + 1) * predict_shape[2]]));
-        // get score
-        max_value = float(*std::max_element(
-            &predict_batch[(m * predict_shape[1] + n) * predict_shape[2]],
-            &predict_batch[(m * predict_shape[1] + n + 1) * predict_shape[2]]));
-
-        if (argmax_idx > 0 && (!(n > 0 && argmax_idx == last_index))) {
-          score += max_value;
-          count += 1;
-          str_res += label_list_[argmax_idx];
+    // with argmax_output the model already gives index and max per step
+    bool argmax_output = this->model_.ArgmaxOutput();
+    const float *max_batch = argmax_output ? this->model_.OutputData(1) : 0;
+    int steps = int(predict_shape[1]);
+    int classes = argmax_output ? 1 : int(predict_shape[2]);
+    // input columns per output timestep
+    float step_cols = float(batch_width) / steps;
+    auto decode = [&](const cv::Range &range) {
+      for (int m = range.start; m < range.end; m++) {
+        const RecPiece &piece = pieces[indices[beg_img_no + m]];
+        std::vector<CtcToken> &tokens =
+            piece_tokens[indices[beg_img_no + m]];
+        // crop columns per resized column
+        float crop_scale = float(piece.cols) / resize_w[m];
+        // timesteps past the resized crop only see padding
+        int valid_steps =
+            std::min(steps, int(std::ceil(resize_w[m] / step_cols)));
+        const float *probs = predict_batch + size_t(m) * steps * classes;
+        int last_index = 0;
+        for (int n = 0; n < valid_steps; n++, probs += classes) {
+          float max_value;
+          int argmax_idx;
+          if (argmax_output) {
+            argmax_idx = int(*probs);
+            max_value = max_batch[size_t(m) * steps + n];
+          } else {
+            argmax_idx = Utility::ArgmaxValue(probs, classes, max_value);
+          }
+          if (argmax_idx > 0 && (!(n > 0 && argmax_idx == last_index))) {
+            CtcToken token;
+            token.index = argmax_idx;
+            token.score = max_value;
+            token.x = piece.x + (n + 0.5f) * step_cols * crop_scale;
+            tokens.push_back(token);
+          }
+          last_index = argmax_idx;
         }
-        last_index = argmax_idx;
       }
-      score /= count;
-      if (std::isnan(score)) {
-        continue;
-      }
-      rec_texts[indices[beg_img_no + m]] = str_res;
-      rec_text_scores[indices[beg_img_no + m]] = score;
+    };
+    // batch items decode into their own token lists
+    if (predict_shape[0] > 1) {
+      cv::parallel_for_(cv::Range(0, int(predict_shape[0])), decode);
+    } else {
+      decode(cv::Range(0, int(predict_shape[0])));
     }
     auto postprocess_end = std::chrono::steady_clock::now();
     postprocess_diff += postprocess_end - postprocess_start;
   }
+
+  auto postprocess_start = std::chrono::steady_clock::now();
+  for (size_t p = 0, next = 0; p < pieces.size(); p = next) {
+    int crop = pieces[p].crop;
+    next = p + 1;
+    while (next < pieces.size() && pieces[next].crop == crop) {
+      next++;
+    }
+    std::vector<CtcToken> tokens;
+    this->MergePieces(pieces, piece_tokens, p, next, img_list[crop].rows,
+                      tokens);
+    std::string str_res;
+    float score = 0.f;
+    int count = 0;
+    for (size_t i = 0; i < tokens.size(); i++) {
+      int index = tokens[i].index;
+      score += tokens[i].score;
+      count += 1;
+      str_res.append(this->label_data_, this->label_offsets_[index],
+                     this->label_offsets_[index + 1] -
+                         this->label_offsets_[index]);
+    }
+    score /= count;
+    if (std::isnan(score)) {
+      continue;
+    }
+    rec_texts[crop] = str_res;
+    rec_text_scores[crop] = score;
+  }
+  auto postprocess_end = std::chrono::steady_clock::now();
+  postprocess_diff += postprocess_end - postprocess_start;
+
   times.push_back(double(preprocess_diff.count() * 1000));
   times.push_back(double(inference_diff.count() * 1000));
   times.push_back(double(postprocess_diff.count() * 1000));
 }
 
-void CRNNRecognizer::LoadModel(const std::string &model_dir) {
-  std::cout << "Load model recognition" << std::endl;
-  std::string model_file = model_dir + "/inference.onnx";
-  this->session = new Ort::Session(this->env, model_file.c_str(), this->sessionOptions);
-  
-  const size_t in_num = session->GetInputCount();
-  Ort::AllocatorWithDefaultOptions allocator;
-  for (int i = 0; i < in_num; ++i) {
-    auto name = session->GetInputNameAllocated(i, allocator);
-    std::cout << "Input Name: " << name.get() << std::endl;
-    
-    auto type_info = session->GetInputTypeInfo(i);
-    auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
-    auto input_node_dims = tensor_info.GetShape();
-    printf("Input num_dims = %zu\n", input_node_dims.size());
-    for (size_t j = 0; j < input_node_dims.size(); j++) {
-        printf("Input dim[%zu] = %llu\n",j, input_node_dims[j]);
+void CRNNRecognizer::SplitWide(const std::vector<cv::Mat> &img_list,
+                               std::vector<cv::Mat> &piece_list,
+                               std::vector<RecPiece> &pieces) const {
+  for (int i = 0; i < int(img_list.size()); i++) {
+    const cv::Mat &img = img_list[i];
+    int chunk_w = int(img.rows * this->rec_max_wh_ratio_);
+    RecPiece piece;
+    piece.crop = i;
+    piece.x = 0;
+    piece.cols = img.cols;
+    if (this->rec_max_wh_ratio_ <= 0 || chunk_w <= 0 || img.cols <= chunk_w) {
+      piece_list.push_back(img);
+      pieces.push_back(piece);
+      continue;
+    }
+    int overlap =
+        std::min(int(img.rows * this->rec_chunk_overlap_), chunk_w / 2);
+    int step = std::max(chunk_w - overlap, 1);
+    piece.cols = chunk_w;
+    // the last chunk is moved left to end at the crop's right edge, so all
+    // chunks have the same width
+    for (int x = 0;; x += step) {
+      piece.x = std::min(x, img.cols - chunk_w);
+      piece_list.push_back(img(cv::Rect(piece.x, 0, chunk_w, img.rows)));
+      pieces.push_back(piece);
+      if (piece.x + chunk_w >= img.cols) {
+        break;
+      }
+    }
+  }
+}
+
+void CRNNRecognizer::MergePieces(
+    const std::vector<RecPiece> &pieces,
+    const std::vector<std::vector<CtcToken>> &piece_tokens, size_t beg,
+    size_t end, int crop_h, std::vector<CtcToken> &tokens) const {
+  // Each chunk contributes the characters it sees between the middles of
+  // its overlaps with the chunks before and after it.
+  float lo = -std::numeric_limits<float>::infinity();
+  for (size_t p = beg; p < end; p++) {
+    float hi = std::numeric_limits<float>::infinity();
+    if (p + 1 < end) {
+      hi = (pieces[p + 1].x + pieces[p].x + pieces[p].cols) / 2.f;
+    }
+    bool first = true;
+    for (size_t i = 0; i < piece_tokens[p].size(); i++) {
+      const CtcToken &token = piece_tokens[p][i];
+      if (token.x < lo || token.x >= hi) {
+        continue;
+      }
+      // a character right at the cut can be decoded on both sides of it
+      if (first && !tokens.empty() && tokens.back().index == token.index &&
+          token.x - tokens.back().x < crop_h / 2) {
+        first = false;
+        continue;
+      }
+      first = false;
+      tokens.push_back(token);
+    }
+    lo = hi;
+  }
+}
+
+int CRNNRecognizer::BatchEnd(const std::vector<float> &width_list,
+                             const std::vector<int> &indices, int beg) const {
+  int img_num = int(indices.size());
+  if (this->rec_batch_width_ <= 0) {
+    return std::min(img_num, beg + this->rec_batch_num_);
+  }
+  // Crops are sorted by aspect ratio, so the one added last sets the batch
+  // width. Padding is counted against the width each crop would have had
+  // alone, i.e. narrow crops padded up to rec_img_w are not waste.
+  int imgH = this->rec_image_shape_[1];
+  int imgW = this->rec_image_shape_[2];
+  double alone_cols = 0;
+  int end = beg;
+  for (; end < img_num; end++) {
+    int width = std::max(imgW, int(imgH * width_list[indices[end]]));
+    double cols = double(end - beg + 1) * width;
+    if (end > beg &&
+        (cols > this->rec_batch_width_ ||
+         1 - (alone_cols + width) / cols > this->rec_max_pad_ratio_)) {
+      break;
     }
+    alone_cols += width;
+  }
+  return end;
+}
+
+void RecBatchStats::Merge(const RecBatchStats &other) {
+  for (auto it = other.shapes.begin(); it != other.shapes.end(); it++) {
+    this->shapes[it->first] += it->second;
   }
+  this->padded_cols += other.padded_cols;
+  this->valid_cols += other.valid_cols;
+}
+
+void RecBatchStats::Reset() {
+  this->shapes.clear();
+  this->padded_cols = 0;
+  this->valid_cols = 0;
+}
+
+void CRNNRecognizer::LoadModel(const std::string &model_dir) {
+  std::cout << "Load model recognition" << std::endl;
+  this->model_.SetInputNormalize(this->mean_, this->scale_, this->is_scale_);
+  this->model_.SetOutputArgmax();
+  this->model_.LoadModel(model_dir + "/inference.onnx", "ocr_rec",
+                         this->runtime_profile_);
 }
 
 } // namespace PaddleOCR
@@ -0,0 +1,607 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <include/onnx_graph.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace PaddleOCR {
+
+namespace {
+
+// protobuf wire types
+const int WIRE_VARINT = 0;
+const int WIRE_FIXED64 = 1;
+const int WIRE_BYTES = 2;
+const int WIRE_FIXED32 = 5;
+
+// field numbers of onnx.proto
+const int MODEL_GRAPH = 7;
+const int MODEL_OPSET_IMPORT = 8;
+const int GRAPH_NODE = 1;
+const int GRAPH_INITIALIZER = 5;
+const int GRAPH_INPUT = 11;
+const int GRAPH_OUTPUT = 12;
+
+// AttributeProto.AttributeType
+const int ATTR_INT = 2;
+const int ATTR_INTS = 7;
+
+bool ReadVarint(const std::string &data, size_t &pos, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+    uint8_t byte = uint8_t(data[pos++]);
+    value |= uint64_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WriteVarint(uint64_t value, std::string &out) {
+  while (value >= 0x80) {
+    out.push_back(char((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(char(value));
+}
+
+void WriteTag(int number, int wire_type, std::string &out) {
+  WriteVarint((uint64_t(number) << 3) | uint64_t(wire_type), out);
+}
+
+void WriteVarintField(int number, int64_t value, std::string &out) {
+  WriteTag(number, WIRE_VARINT, out);
+  WriteVarint(uint64_t(value), out);
+}
+
+void WriteBytesField(int number, const std::string &bytes, std::string &out) {
+  WriteTag(number, WIRE_BYTES, out);
+  WriteVarint(bytes.size(), out);
+  out += bytes;
+}
+
+std::string EncodeTensor(const std::string &name,
+                         const std::vector<int64_t> &dims, int data_type,
+                         const void *data, size_t size) {
+  std::string tensor;
+  for (size_t i = 0; i < dims.size(); i++) {
+    WriteVarintField(1, dims[i], tensor);
+  }
+  WriteVarintField(2, data_type, tensor);
+  WriteBytesField(8, name, tensor);
+  // raw_data is little endian, as are all hosts this runs on
+  WriteBytesField(9, std::string(static_cast<const char *>(data), size),
+                  tensor);
+  return tensor;
+}
+
+} // namespace
+
+bool OnnxGraph::ParseFields(const std::string &data,
+                            std::vector<Field> &fields) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    uint64_t tag = 0;
+    if (!ReadVarint(data, pos, tag)) {
+      return false;
+    }
+    Field field;
+    field.number = int(tag >> 3);
+    field.wire_type = int(tag & 7);
+    if (field.wire_type == WIRE_VARINT) {
+      if (!ReadVarint(data, pos, field.value)) {
+        return false;
+      }
+    } else if (field.wire_type == WIRE_BYTES) {
+      uint64_t size = 0;
+      if (!ReadVarint(data, pos, size) || size > data.size() - pos) {
+        return false;
+      }
+      field.bytes = data.substr(pos, size);
+      pos += size;
+    } else if (field.wire_type == WIRE_FIXED64 ||
+               field.wire_type == WIRE_FIXED32) {
+      size_t size = field.wire_type == WIRE_FIXED64 ? 8 : 4;
+      if (size > data.size() - pos) {
+        return false;
+      }
+      field.bytes = data.substr(pos, size);
+      pos += size;
+    } else {
+      return false;
+    }
+    fields.push_back(field);
+  }
+  return true;
+}
+
+void OnnxGraph::WriteField(const Field &field, std::string &out) {
+  WriteTag(field.number, field.wire_type, out);
+  if (field.wire_type == WIRE_VARINT) {
+    WriteVarint(field.value, out);
+    return;
+  }
+  if (field.wire_type == WIRE_BYTES) {
+    WriteVarint(field.bytes.size(), out);
+  }
+  out += field.bytes;
+}
+
+bool OnnxGraph::ParseValueInfo(const std::string &data, OnnxValueInfo &info) {
+  // ValueInfoProto { name = 1; type = 2 }
+  // TypeProto { tensor_type = 1 } Tensor { elem_type = 1; shape = 2 }
+  // TensorShapeProto { dim = 1 } Dimension { dim_value = 1; dim_param = 2 }
+  std::vector<Field> fields;
+  if (!ParseFields(data, fields)) {
+    return false;
+  }
+  info = OnnxValueInfo();
+  info.elem_type = 0;
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (fields[i].number == 1 && fields[i].wire_type == WIRE_BYTES) {
+      info.name = fields[i].bytes;
+    } else if (fields[i].number == 2 && fields[i].wire_type == WIRE_BYTES) {
+      std::vector<Field> type_fields;
+      if (!ParseFields(fields[i].bytes, type_fields)) {
+        return false;
+      }
+      for (size_t j = 0; j < type_fields.size(); j++) {
+        if (type_fields[j].number != 1) {
+          continue;
+        }
+        std::vector<Field> tensor_fields;
+        if (!ParseFields(type_fields[j].bytes, tensor_fields)) {
+          return false;
+        }
+        for (size_t k = 0; k < tensor_fields.size(); k++) {
+          if (tensor_fields[k].number == 1) {
+            info.elem_type = int(tensor_fields[k].value);
+            continue;
+          }
+          std::vector<Field> shape_fields;
+          if (tensor_fields[k].number != 2 ||
+              !ParseFields(tensor_fields[k].bytes, shape_fields)) {
+            continue;
+          }
+          for (size_t d = 0; d < shape_fields.size(); d++) {
+            std::vector<Field> dim_fields;
+            ParseFields(shape_fields[d].bytes, dim_fields);
+            int64_t dim = -1;
+            std::string param;
+            for (size_t f = 0; f < dim_fields.size(); f++) {
+              if (dim_fields[f].number == 1) {
+                dim = int64_t(dim_fields[f].value);
+              } else if (dim_fields[f].number == 2) {
+                param = dim_fields[f].bytes;
+              }
+            }
+            info.dims.push_back(dim);
+            info.dim_params.push_back(param);
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+std::string OnnxGraph::EncodeValueInfo(const OnnxValueInfo &info) {
+  std::string shape;
+  for (size_t i = 0; i < info.dims.size(); i++) {
+    std::string dim;
+    if (info.dims[i] >= 0) {
+      WriteVarintField(1, info.dims[i], dim);
+    } else if (i < info.dim_params.size() && !info.dim_params[i].empty()) {
+      WriteBytesField(2, info.dim_params[i], dim);
+    }
+    WriteBytesField(1, dim, shape);
+  }
+  std::string tensor;
+  WriteVarintField(1, info.elem_type, tensor);
+  WriteBytesField(2, shape, tensor);
+  std::string type;
+  WriteBytesField(1, tensor, type);
+  std::string value_info;
+  WriteBytesField(1, info.name, value_info);
+  WriteBytesField(2, type, value_info);
+  return value_info;
+}
+
+std::string OnnxGraph::EncodeNode(const OnnxNode &node) {
+  // NodeProto { input = 1; output = 2; name = 3; op_type = 4; attribute = 5 }
+  // AttributeProto { name = 1; i = 3; ints = 8; type = 20 }
+  std::string out;
+  for (size_t i = 0; i < node.inputs.size(); i++) {
+    WriteBytesField(1, node.inputs[i], out);
+  }
+  for (size_t i = 0; i < node.outputs.size(); i++) {
+    WriteBytesField(2, node.outputs[i], out);
+  }
+  WriteBytesField(3, node.op_type + "_" + node.outputs[0], out);
+  WriteBytesField(4, node.op_type, out);
+  for (size_t i = 0; i < node.int_attrs.size(); i++) {
+    std::string attr;
+    WriteBytesField(1, node.int_attrs[i].first, attr);
+    WriteVarintField(3, node.int_attrs[i].second, attr);
+    WriteVarintField(20, ATTR_INT, attr);
+    WriteBytesField(5, attr, out);
+  }
+  for (size_t i = 0; i < node.ints_attrs.size(); i++) {
+    std::string attr;
+    WriteBytesField(1, node.ints_attrs[i].first, attr);
+    const std::vector<int64_t> &values = node.ints_attrs[i].second;
+    for (size_t j = 0; j < values.size(); j++) {
+      WriteVarintField(8, values[j], attr);
+    }
+    WriteVarintField(20, ATTR_INTS, attr);
+    WriteBytesField(5, attr, out);
+  }
+  return out;
+}
+
+bool OnnxGraph::Parse(const std::string &model) {
+  *this = OnnxGraph();
+  if (!ParseFields(model, this->model_fields_)) {
+    return false;
+  }
+  bool has_graph = false;
+  for (size_t i = 0; i < this->model_fields_.size(); i++) {
+    const Field &field = this->model_fields_[i];
+    if (field.wire_type != WIRE_BYTES) {
+      continue;
+    }
+    if (field.number == MODEL_GRAPH) {
+      if (!ParseFields(field.bytes, this->graph_fields_)) {
+        return false;
+      }
+      has_graph = true;
+    } else if (field.number == MODEL_OPSET_IMPORT) {
+      // OperatorSetIdProto { domain = 1; version = 2 }
+      std::vector<Field> opset;
+      ParseFields(field.bytes, opset);
+      std::string domain;
+      int64_t version = 0;
+      for (size_t j = 0; j < opset.size(); j++) {
+        if (opset[j].number == 1) {
+          domain = opset[j].bytes;
+        } else if (opset[j].number == 2) {
+          version = int64_t(opset[j].value);
+        }
+      }
+      if (domain.empty() || domain == "ai.onnx") {
+        this->opset_version_ = version;
+      }
+    }
+  }
+  if (!has_graph) {
+    return false;
+  }
+
+  for (size_t i = 0; i < this->graph_fields_.size(); i++) {
+    const Field &field = this->graph_fields_[i];
+    if (field.wire_type != WIRE_BYTES) {
+      continue;
+    }
+    if (field.number == GRAPH_INPUT || field.number == GRAPH_OUTPUT) {
+      OnnxValueInfo info;
+      if (!ParseValueInfo(field.bytes, info)) {
+        return false;
+      }
+      (field.number == GRAPH_INPUT ? this->inputs_ : this->outputs_)
+          .push_back(info);
+    } else if (field.number == GRAPH_INITIALIZER) {
+      // TensorProto { name = 8 }
+      std::vector<Field> tensor;
+      ParseFields(field.bytes, tensor);
+      for (size_t j = 0; j < tensor.size(); j++) {
+        if (tensor[j].number == 8 && tensor[j].wire_type == WIRE_BYTES) {
+          this->initializer_names_.push_back(tensor[j].bytes);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+std::string OnnxGraph::Serialize() const {
+  std::string graph;
+  for (size_t i = 0; i < this->prepended_nodes_.size(); i++) {
+    WriteBytesField(GRAPH_NODE, this->prepended_nodes_[i], graph);
+  }
+  bool inputs_written = false;
+  bool outputs_written = false;
+  for (size_t i = 0; i < this->graph_fields_.size(); i++) {
+    const Field &field = this->graph_fields_[i];
+    if (field.number == GRAPH_INPUT && this->inputs_changed_) {
+      if (!inputs_written) {
+        for (size_t j = 0; j < this->inputs_.size(); j++) {
+          WriteBytesField(GRAPH_INPUT, EncodeValueInfo(this->inputs_[j]),
+                          graph);
+        }
+        inputs_written = true;
+      }
+      continue;
+    }
+    if (field.number == GRAPH_OUTPUT && this->outputs_changed_) {
+      if (!outputs_written) {
+        for (size_t j = 0; j < this->outputs_.size(); j++) {
+          WriteBytesField(GRAPH_OUTPUT, EncodeValueInfo(this->outputs_[j]),
+                          graph);
+        }
+        outputs_written = true;
+      }
+      continue;
+    }
+    WriteField(field, graph);
+  }
+  // nodes after the original ones keep the graph topologically sorted
+  for (size_t i = 0; i < this->appended_nodes_.size(); i++) {
+    WriteBytesField(GRAPH_NODE, this->appended_nodes_[i], graph);
+  }
+  for (size_t i = 0; i < this->initializers_.size(); i++) {
+    WriteBytesField(GRAPH_INITIALIZER, this->initializers_[i], graph);
+  }
+
+  std::string model;
+  for (size_t i = 0; i < this->model_fields_.size(); i++) {
+    const Field &field = this->model_fields_[i];
+    if (field.number == MODEL_GRAPH && field.wire_type == WIRE_BYTES) {
+      WriteBytesField(MODEL_GRAPH, graph, model);
+    } else {
+      WriteField(field, model);
+    }
+  }
+  return model;
+}
+
+bool OnnxGraph::IsInitializer(const std::string &name) const {
+  return std::find(this->initializer_names_.begin(),
+                   this->initializer_names_.end(),
+                   name) != this->initializer_names_.end();
+}
+
+void OnnxGraph::SetInputs(const std::vector<OnnxValueInfo> &inputs) {
+  this->inputs_ = inputs;
+  this->inputs_changed_ = true;
+}
+
+void OnnxGraph::SetOutputs(const std::vector<OnnxValueInfo> &outputs) {
+  this->outputs_ = outputs;
+  this->outputs_changed_ = true;
+}
+
+void OnnxGraph::PrependNode(const OnnxNode &node) {
+  this->prepended_nodes_.push_back(EncodeNode(node));
+}
+
+void OnnxGraph::AppendNode(const OnnxNode &node) {
+  this->appended_nodes_.push_back(EncodeNode(node));
+}
+
+void OnnxGraph::AddInitializer(const std::string &name,
+                               const std::vector<int64_t> &dims,
+                               const std::vector<float> &data) {
+  this->initializers_.push_back(EncodeTensor(
+      name, dims, ONNX_FLOAT, data.data(), data.size() * sizeof(float)));
+  this->initializer_names_.push_back(name);
+}
+
+void OnnxGraph::AddInitializer(const std::string &name,
+                               const std::vector<int64_t> &dims,
+                               const std::vector<int64_t> &data) {
+  this->initializers_.push_back(EncodeTensor(
+      name, dims, ONNX_INT64, data.data(), data.size() * sizeof(int64_t)));
+  this->initializer_names_.push_back(name);
+}
+
+void OnnxGraph::AddInitializer(const std::string &name,
+                               const std::vector<int64_t> &dims,
+                               const std::vector<uint8_t> &data) {
+  this->initializers_.push_back(
+      EncodeTensor(name, dims, ONNX_UINT8, data.data(), data.size()));
+  this->initializer_names_.push_back(name);
+}
+
+bool OnnxGraph::FoldInputNormalize(const std::vector<float> &mean,
+                                   const std::vector<float> &scale,
+                                   const bool is_scale) {
+  size_t index = 0;
+  while (index < this->inputs_.size() &&
+         this->IsInitializer(this->inputs_[index].name)) {
+    index++;
+  }
+  if (index == this->inputs_.size()) {
+    return false;
+  }
+  const OnnxValueInfo &input = this->inputs_[index];
+  if (input.elem_type != ONNX_FLOAT || input.dims.size() != 4 ||
+      (input.dims[1] != 3 && input.dims[1] != -1) || mean.size() != 3 ||
+      scale.size() != 3) {
+    return false;
+  }
+
+  // NCHW float -> NHWC uint8
+  OnnxValueInfo image;
+  image.name = input.name + "_uint8";
+  image.elem_type = ONNX_UINT8;
+  const int nhwc[4] = {0, 2, 3, 1};
+  for (int i = 0; i < 4; i++) {
+    image.dims.push_back(input.dims[nhwc[i]]);
+    image.dim_params.push_back(input.dim_params[nhwc[i]]);
+  }
+  image.dims[3] = 3;
+  image.dim_params[3].clear();
+
+  // value * alpha + beta == (value * e - mean) * scale
+  const float e = is_scale ? 1.f / 255.f : 1.f;
+  std::vector<float> alpha(3);
+  std::vector<float> beta(3);
+  for (int c = 0; c < 3; c++) {
+    alpha[c] = e * scale[c];
+    beta[c] = -mean[c] * scale[c];
+  }
+  this->AddInitializer(input.name + "_alpha", {1, 3, 1, 1}, alpha);
+  this->AddInitializer(input.name + "_beta", {1, 3, 1, 1}, beta);
+
+  // transpose while the data is still one byte per value
+  OnnxNode transpose;
+  transpose.op_type = "Transpose";
+  transpose.inputs = {image.name};
+  transpose.outputs = {input.name + "_nchw"};
+  transpose.ints_attrs.push_back(
+      std::make_pair(std::string("perm"), std::vector<int64_t>{0, 3, 1, 2}));
+  OnnxNode cast;
+  cast.op_type = "Cast";
+  cast.inputs = {input.name + "_nchw"};
+  cast.outputs = {input.name + "_float"};
+  cast.int_attrs.push_back(std::make_pair(std::string("to"), ONNX_FLOAT));
+  OnnxNode mul;
+  mul.op_type = "Mul";
+  mul.inputs = {input.name + "_float", input.name + "_alpha"};
+  mul.outputs = {input.name + "_scaled"};
+  // the last node produces the old input, so nothing else has to change
+  OnnxNode add;
+  add.op_type = "Add";
+  add.inputs = {input.name + "_scaled", input.name + "_beta"};
+  add.outputs = {input.name};
+  this->PrependNode(transpose);
+  this->PrependNode(cast);
+  this->PrependNode(mul);
+  this->PrependNode(add);
+
+  std::vector<OnnxValueInfo> inputs = this->inputs_;
+  inputs[index] = image;
+  this->SetInputs(inputs);
+  return true;
+}
+
+bool OnnxGraph::ReduceOutputArgmax() {
+  if (this->outputs_.empty()) {
+    return false;
+  }
+  const OnnxValueInfo &output = this->outputs_[0];
+  if (output.elem_type != ONNX_FLOAT || output.dims.size() < 2) {
+    return false;
+  }
+  const int64_t axis = int64_t(output.dims.size()) - 1;
+  OnnxValueInfo index = output;
+  index.name = output.name + "_index";
+  index.dims.pop_back();
+  index.dim_params.pop_back();
+  OnnxValueInfo max = index;
+  max.name = output.name + "_max";
+
+  OnnxNode argmax;
+  argmax.op_type = "ArgMax";
+  argmax.inputs = {output.name};
+  argmax.outputs = {output.name + "_argmax"};
+  argmax.int_attrs.push_back(std::make_pair(std::string("axis"), axis));
+  argmax.int_attrs.push_back(
+      std::make_pair(std::string("keepdims"), int64_t(0)));
+  // ArgMax gives int64, class indices are exact in float
+  OnnxNode cast;
+  cast.op_type = "Cast";
+  cast.inputs = {output.name + "_argmax"};
+  cast.outputs = {index.name};
+  cast.int_attrs.push_back(std::make_pair(std::string("to"), ONNX_FLOAT));
+  OnnxNode reduce;
+  reduce.op_type = "ReduceMax";
+  reduce.inputs = {output.name};
+  reduce.outputs = {max.name};
+  reduce.int_attrs.push_back(
+      std::make_pair(std::string("keepdims"), int64_t(0)));
+  // axes moved from an attribute to an input in opset 18
+  if (this->opset_version_ >= 18) {
+    this->AddInitializer(output.name + "_axes", {1},
+                         std::vector<int64_t>{axis});
+    reduce.inputs.push_back(output.name + "_axes");
+  } else {
+    reduce.ints_attrs.push_back(
+        std::make_pair(std::string("axes"), std::vector<int64_t>{axis}));
+  }
+  this->AppendNode(argmax);
+  this->AppendNode(cast);
+  this->AppendNode(reduce);
+
+  std::vector<OnnxValueInfo> outputs = this->outputs_;
+  outputs[0] = index;
+  outputs.insert(outputs.begin() + 1, max);
+  this->SetOutputs(outputs);
+  return true;
+}
+
+bool OnnxGraph::ThresholdOutputMap(float thresh, bool quantize) {
+  // Greater and Mul broadcast from opset 7 on
+  if (this->outputs_.empty() || this->opset_version_ < 7) {
+    return false;
+  }
+  const OnnxValueInfo &output = this->outputs_[0];
+  if (output.elem_type != ONNX_FLOAT) {
+    return false;
+  }
+  OnnxValueInfo map = output;
+  map.name = output.name + "_uint8";
+  map.elem_type = ONNX_UINT8;
+  OnnxValueInfo bitmap = map;
+  bitmap.name = output.name + "_bitmap";
+
+  // the C++ side sets (unsigned char)(p * 255) > thresh * 255, i.e. for the
+  // truncated integer q > floor(thresh * 255), which is p * 255 >= level + 1;
+  // Greater on float needs the largest float below that (ORT has no Greater
+  // on uint8)
+  float level = std::floor(thresh * 255.f);
+  level = std::min(std::max(level, 0.f), 255.f);
+  this->AddInitializer(output.name + "_255", {1}, std::vector<float>{255.f});
+  this->AddInitializer(output.name + "_level", {1},
+                       std::vector<float>{std::nextafter(level + 1, 0.f)});
+
+  OnnxNode mul;
+  mul.op_type = "Mul";
+  mul.inputs = {output.name, output.name + "_255"};
+  mul.outputs = {output.name + "_scaled"};
+  OnnxNode greater;
+  greater.op_type = "Greater";
+  greater.inputs = {output.name + "_scaled", output.name + "_level"};
+  greater.outputs = {output.name + "_mask"};
+  // true/false become 1/0, which is all findContours and dilate look at
+  OnnxNode to_bitmap;
+  to_bitmap.op_type = "Cast";
+  to_bitmap.inputs = {output.name + "_mask"};
+  to_bitmap.outputs = {bitmap.name};
+  to_bitmap.int_attrs.push_back(std::make_pair(std::string("to"), ONNX_UINT8));
+  this->AppendNode(mul);
+  this->AppendNode(greater);
+  this->AppendNode(to_bitmap);
+
+  std::vector<OnnxValueInfo> outputs = this->outputs_;
+  if (quantize) {
+    // float to uint8 truncates, as the C++ cast does
+    OnnxNode cast;
+    cast.op_type = "Cast";
+    cast.inputs = {output.name + "_scaled"};
+    cast.outputs = {map.name};
+    cast.int_attrs.push_back(std::make_pair(std::string("to"), ONNX_UINT8));
+    this->AppendNode(cast);
+    outputs[0] = map;
+  }
+  outputs.insert(outputs.begin() + 1, bitmap);
+  this->SetOutputs(outputs);
+  return true;
+}
+
+} // namespace PaddleOCR
@@ -0,0 +1,479 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <include/onnx_model.h>
+
+#include <include/onnx_graph.h>
+#include <include/utility.h>
+
+#include <onnxruntime_session_options_config_keys.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+
+namespace PaddleOCR {
+
+namespace {
+std::mutex env_mutex;
+std::unique_ptr<Ort::Env> shared_env;
+bool global_thread_pool_enabled = false;
+
+// Input shapes whose output shapes are remembered; det sees a new input shape
+// with nearly every page, so the cache is dropped once it is full.
+const size_t kMaxCachedShapes = 64;
+
+// Instruction set tier of this CPU, which a graph optimized at level "all"
+// may be specialized for (the NCHWc block size differs between AVX2 and
+// AVX-512). Empty where it cannot be told.
+std::string CpuTier() {
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+  if (__builtin_cpu_supports("avx512f")) {
+    return "avx512";
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return "avx2";
+  }
+  if (__builtin_cpu_supports("avx")) {
+    return "avx";
+  }
+  return "sse";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  // ORT has no CPU specific layouts on arm64
+  return "arm64";
+#else
+  return "";
+#endif
+}
+
+// Whether `e` is ORT refusing a bound output because this run computed a
+// different shape for it (the message differs between ORT versions).
+bool IsOutputShapeMismatch(const Ort::Exception &e) {
+  std::string what = e.what();
+  return what.find("Shape mismatch attempting to re-use buffer") !=
+             std::string::npos ||
+         what.find("computed output shape for this run") != std::string::npos;
+}
+} // namespace
+
+void OnnxModel::InitEnv(const RuntimeProfile &profile) {
+  std::lock_guard<std::mutex> lock(env_mutex);
+  if (shared_env) {
+    return;
+  }
+  if (profile.global_thread_pool) {
+    Ort::ThreadingOptions threading_options;
+    threading_options.SetGlobalIntraOpNumThreads(profile.intra_op_threads);
+    threading_options.SetGlobalInterOpNumThreads(profile.inter_op_threads);
+    threading_options.SetGlobalSpinControl(profile.allow_spinning ? 1 : 0);
+    shared_env.reset(
+        new Ort::Env(threading_options, ORT_LOGGING_LEVEL_ERROR, "ppocr"));
+  } else {
+    shared_env.reset(new Ort::Env(ORT_LOGGING_LEVEL_ERROR, "ppocr"));
+  }
+  global_thread_pool_enabled = profile.global_thread_pool;
+}
+
+Ort::Env &OnnxModel::SharedEnv() {
+  std::lock_guard<std::mutex> lock(env_mutex);
+  if (!shared_env) {
+    shared_env.reset(new Ort::Env(ORT_LOGGING_LEVEL_ERROR, "ppocr"));
+  }
+  return *shared_env;
+}
+
+bool OnnxModel::UseGlobalThreadPool() {
+  std::lock_guard<std::mutex> lock(env_mutex);
+  return global_thread_pool_enabled;
+}
+
+OnnxModel::OnnxModel(const OnnxModel &other)
+    : state_(other.state_), output_shape_cache_(other.output_shape_cache_),
+      dynamic_outputs_(other.dynamic_outputs_) {}
+
+void OnnxModel::LoadModel(const std::string &model_file,
+                          const std::string &log_id,
+                          const RuntimeProfile &profile) {
+  // fail on a wrong path right away, even if loading is deferred
+  if (!Utility::PathExists(model_file)) {
+    std::cerr << "[ERROR] no such model file: " << model_file << std::endl;
+    exit(1);
+  }
+  SharedState *state = this->state_.get();
+  state->model_file = model_file;
+  state->log_id = log_id;
+  state->profile = profile;
+  if (profile.load_mode == "parallel") {
+    // the state waits for this in its destructor, so it outlives the load
+    state->loading = std::async(std::launch::async,
+                                [state]() { CreateSession(*state); });
+  } else if (profile.load_mode == "serial") {
+    this->EnsureLoaded();
+  }
+}
+
+void OnnxModel::EnsureLoaded() {
+  SharedState &state = *this->state_;
+  std::call_once(state.load_once, [&state]() {
+    if (state.loading.valid()) {
+      state.loading.get();
+    } else {
+      CreateSession(state);
+    }
+  });
+  if (this->binding_) {
+    return;
+  }
+  // first use of this copy: its own binding to the shared session; the
+  // names never move again once loaded, so the raw pointers stay valid
+  this->memory_info_ =
+      Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+  this->binding_ = Ort::IoBinding(*state.session);
+  for (size_t i = 0; i < state.input_names.size(); i++) {
+    this->input_names_ptr_.push_back(state.input_names[i].c_str());
+  }
+  for (size_t i = 0; i < state.output_names.size(); i++) {
+    this->output_names_ptr_.push_back(state.output_names[i].c_str());
+  }
+}
+
+void OnnxModel::CreateSession(SharedState &state) {
+  const std::string &model_file = state.model_file;
+  const RuntimeProfile &profile = state.profile;
+  auto load_start = std::chrono::steady_clock::now();
+  // a model can only join the shared pool if the env was built with one
+  RuntimeProfile session_profile = profile;
+  session_profile.global_thread_pool =
+      profile.global_thread_pool && UseGlobalThreadPool();
+  state.session_options.SetLogId(state.log_id.c_str());
+  bool other_provider = session_profile.Apply(state.session_options);
+  if (session_profile.global_thread_pool) {
+    state.session_options.DisablePerSessionThreads();
+  }
+
+  std::ifstream in(model_file, std::ios::binary);
+  if (!in) {
+    std::cerr << "[ERROR] no such model file: " << model_file << std::endl;
+    exit(1);
+  }
+  std::string model_data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+
+  if (session_profile.fold_normalize && !state.normalize_mean.empty()) {
+    OnnxGraph graph;
+    state.folded_normalize =
+        graph.Parse(model_data) &&
+        graph.FoldInputNormalize(state.normalize_mean, state.normalize_scale,
+                                 state.normalize_is_scale);
+    if (state.folded_normalize) {
+      model_data = graph.Serialize();
+    } else {
+      std::cerr << "[WARNING] fold_normalize ignored, no NCHW float input in "
+                << model_file << std::endl;
+    }
+  }
+  if (session_profile.argmax_output && state.argmax_wanted) {
+    OnnxGraph graph;
+    state.argmax_output =
+        graph.Parse(model_data) && graph.ReduceOutputArgmax();
+    if (state.argmax_output) {
+      model_data = graph.Serialize();
+    } else {
+      std::cerr << "[WARNING] argmax_output ignored, no float output in "
+                << model_file << std::endl;
+    }
+  }
+  if (state.bitmap_thresh >= 0) {
+    OnnxGraph graph;
+    state.output_bitmap =
+        graph.Parse(model_data) &&
+        graph.ThresholdOutputMap(state.bitmap_thresh, state.bitmap_quantize);
+    if (state.output_bitmap) {
+      model_data = graph.Serialize();
+    } else {
+      std::cerr << "[WARNING] bitmap output ignored, no float output or "
+                << "opset < 7 in " << model_file << std::endl;
+    }
+  }
+
+  std::string cache_file;
+  if (session_profile.model_cache && other_provider) {
+    // ORT refuses to save a graph with nodes compiled by another provider
+    std::cerr << "[WARNING] model_cache ignored with enable_mkldnn for "
+              << model_file << std::endl;
+  } else if (session_profile.model_cache &&
+             session_profile.graph_optimization_level == "all" &&
+             CpuTier().empty()) {
+    // the graph may be laid out for this CPU, and the key cannot say which
+    std::cerr << "[WARNING] model_cache ignored with graph_optimization_level"
+              << "=all on this CPU for " << model_file << std::endl;
+  } else if (session_profile.model_cache) {
+    cache_file = CachePath(model_file, model_data, session_profile);
+  }
+  state.cache_hit = !cache_file.empty() && Utility::PathExists(cache_file);
+  if (state.cache_hit) {
+    // the cached graph is already optimized for exactly these options
+    if (session_profile.model_cache_format == "onnx") {
+      state.session_options.SetGraphOptimizationLevel(
+          GraphOptimizationLevel::ORT_DISABLE_ALL);
+    }
+    state.session.reset(new Ort::Session(SharedEnv(), cache_file.c_str(),
+                                          state.session_options));
+    std::cout << "Load optimized model from cache: " << cache_file
+              << std::endl;
+  } else if (!cache_file.empty()) {
+    // write next to the final name and rename, so that workers starting at
+    // the same time never load a half written file
+    std::string tmp_file =
+        cache_file + ".tmp" +
+        std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+    state.session_options.SetOptimizedModelFilePath(tmp_file.c_str());
+    if (session_profile.model_cache_format == "ort") {
+      state.session_options.AddConfigEntry(
+          kOrtSessionOptionsConfigSaveModelFormat, "ORT");
+    }
+    try {
+      state.session.reset(new Ort::Session(SharedEnv(), model_data.data(),
+                                            model_data.size(),
+                                            state.session_options));
+    } catch (...) {
+      // ORT may have written part of the graph before failing
+      std::remove(tmp_file.c_str());
+      throw;
+    }
+    if (std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+      std::remove(tmp_file.c_str());
+    } else {
+      std::cout << "Save optimized model to cache: " << cache_file
+                << std::endl;
+    }
+  } else {
+    state.session.reset(new Ort::Session(SharedEnv(), model_data.data(),
+                                          model_data.size(),
+                                          state.session_options));
+  }
+
+  Ort::AllocatorWithDefaultOptions allocator;
+  const size_t in_num = state.session->GetInputCount();
+  for (size_t i = 0; i < in_num; i++) {
+    auto name = state.session->GetInputNameAllocated(i, allocator);
+    state.input_names.push_back(name.get());
+    state.input_dims.push_back(state.session->GetInputTypeInfo(i)
+                                    .GetTensorTypeAndShapeInfo()
+                                    .GetShape());
+  }
+  const size_t out_num = state.session->GetOutputCount();
+  for (size_t i = 0; i < out_num; i++) {
+    auto name = state.session->GetOutputNameAllocated(i, allocator);
+    state.output_names.push_back(name.get());
+    state.output_types.push_back(state.session->GetOutputTypeInfo(i)
+                                      .GetTensorTypeAndShapeInfo()
+                                      .GetElementType());
+  }
+  std::chrono::duration<float> load_diff =
+      std::chrono::steady_clock::now() - load_start;
+  state.load_time = double(load_diff.count() * 1000);
+  state.loaded = true;
+}
+
+std::string OnnxModel::CachePath(const std::string &model_file,
+                                 const std::string &model_data,
+                                 const RuntimeProfile &profile) {
+  // FNV-1a over the model bytes (after our own rewrites) and everything
+  // else that changes the optimized graph: optimization level, execution
+  // provider, CPU tier, format, ORT version
+  std::string options = profile.graph_optimization_level + "," +
+                        (profile.use_mkldnn ? "dnnl" : "cpu") + "," +
+                        CpuTier() + "," + profile.model_cache_format + "," +
+                        Ort::GetVersionString();
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < model_data.size(); i++) {
+    hash = (hash ^ uint8_t(model_data[i])) * 1099511628211ULL;
+  }
+  for (size_t i = 0; i < options.size(); i++) {
+    hash = (hash ^ uint8_t(options[i])) * 1099511628211ULL;
+  }
+  char key[17];
+  snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+
+  std::string dir = profile.model_cache_dir;
+  std::string name = Utility::basename(model_file);
+  if (dir.empty()) {
+    size_t pos = model_file.find_last_of("/\\");
+    dir = pos == std::string::npos ? "." : model_file.substr(0, pos);
+  } else if (!Utility::PathExists(dir)) {
+    Utility::CreateDir(dir);
+  }
+  name = name.substr(0, name.find_last_of('.'));
+  return dir + "/" + name + "." + key + ".opt." +
+         profile.model_cache_format;
+}
+
+void OnnxModel::SetInputNormalize(const std::vector<float> &mean,
+                                  const std::vector<float> &scale,
+                                  const bool is_scale) {
+  this->state_->normalize_mean = mean;
+  this->state_->normalize_scale = scale;
+  this->state_->normalize_is_scale = is_scale;
+}
+
+bool OnnxModel::FoldedNormalize() {
+  this->EnsureLoaded();
+  return this->state_->folded_normalize;
+}
+
+bool OnnxModel::ArgmaxOutput() {
+  this->EnsureLoaded();
+  return this->state_->argmax_output;
+}
+
+void OnnxModel::SetOutputBitmap(float thresh, bool quantize) {
+  this->state_->bitmap_thresh = thresh;
+  this->state_->bitmap_quantize = quantize;
+}
+
+bool OnnxModel::OutputBitmap() {
+  this->EnsureLoaded();
+  return this->state_->output_bitmap;
+}
+
+template <class T>
+T *OnnxModel::InputBuffer(const std::vector<int64_t> &shape,
+                          std::vector<T> &buffer) {
+  this->EnsureLoaded();
+  int64_t count = std::accumulate(shape.begin(), shape.end(), int64_t(1),
+                                  std::multiplies<int64_t>());
+  const T *old_data = buffer.data();
+  if (buffer.size() < size_t(count)) {
+    buffer.resize(count);
+  }
+  if (shape != this->input_shape_ || old_data != buffer.data() ||
+      !this->input_tensor_) {
+    this->input_shape_ = shape;
+    this->input_tensor_ = Ort::Value::CreateTensor<T>(
+        this->memory_info_, buffer.data(), size_t(count),
+        this->input_shape_.data(), this->input_shape_.size());
+  }
+  return buffer.data();
+}
+
+float *OnnxModel::InputData(const std::vector<int64_t> &shape) {
+  return this->InputBuffer(shape, this->input_data_);
+}
+
+uint8_t *OnnxModel::ByteInputData(const std::vector<int64_t> &shape) {
+  return this->InputBuffer(shape, this->input_bytes_);
+}
+
+void OnnxModel::Run() {
+  this->EnsureLoaded();
+  this->binding_.BindInput(this->input_names_ptr_[0], this->input_tensor_);
+
+  auto cached = this->output_shape_cache_.find(this->input_shape_);
+  if (this->dynamic_outputs_ || cached == this->output_shape_cache_.end()) {
+    this->RunAllocated();
+    if (!this->dynamic_outputs_) {
+      if (this->output_shape_cache_.size() >= kMaxCachedShapes) {
+        this->output_shape_cache_.clear();
+      }
+      this->output_shape_cache_[this->input_shape_] = this->output_shapes_;
+    }
+    return;
+  }
+
+  // known geometry: bind the outputs to our own buffers, which are only
+  // rebound when the shape changes and never reallocated once big enough
+  if (this->input_shape_ != this->bound_shape_) {
+    this->output_shapes_ = cached->second;
+    this->binding_.ClearBoundOutputs();
+    this->output_tensors_.clear();
+    this->output_data_.resize(this->output_shapes_.size());
+    for (size_t i = 0; i < this->output_shapes_.size(); i++) {
+      std::vector<int64_t> &shape = this->output_shapes_[i];
+      size_t count = size_t(this->OutputSize(i));
+      bool bytes =
+          this->state_->output_types[i] == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+      size_t floats = bytes ? (count + 3) / 4 : count;
+      if (this->output_data_[i].size() < floats) {
+        this->output_data_[i].resize(floats);
+      }
+      if (bytes) {
+        this->output_tensors_.push_back(Ort::Value::CreateTensor<uint8_t>(
+            this->memory_info_,
+            reinterpret_cast<uint8_t *>(this->output_data_[i].data()), count,
+            shape.data(), shape.size()));
+      } else {
+        this->output_tensors_.push_back(Ort::Value::CreateTensor<float>(
+            this->memory_info_, this->output_data_[i].data(), count,
+            shape.data(), shape.size()));
+      }
+      this->binding_.BindOutput(this->output_names_ptr_[i],
+                                this->output_tensors_[i]);
+    }
+    this->bound_shape_ = this->input_shape_;
+  }
+  try {
+    this->state_->session->Run(Ort::RunOptions{nullptr}, this->binding_);
+  } catch (const Ort::Exception &e) {
+    if (!IsOutputShapeMismatch(e)) {
+      throw;
+    }
+    // some output shape depends on the data, not only on the input shape
+    this->RunAllocated();
+    this->dynamic_outputs_ = true;
+    this->output_shape_cache_.clear();
+  }
+}
+
+void OnnxModel::RunAllocated() {
+  this->binding_.ClearBoundOutputs();
+  for (size_t i = 0; i < this->output_names_ptr_.size(); i++) {
+    this->binding_.BindOutput(this->output_names_ptr_[i], this->memory_info_);
+  }
+  this->bound_shape_.clear();
+  this->state_->session->Run(Ort::RunOptions{nullptr}, this->binding_);
+  this->output_tensors_ = this->binding_.GetOutputValues();
+  this->output_shapes_.clear();
+  for (size_t i = 0; i < this->output_tensors_.size(); i++) {
+    this->output_shapes_.push_back(
+        this->output_tensors_[i].GetTensorTypeAndShapeInfo().GetShape());
+  }
+}
+
+const float *OnnxModel::OutputData(size_t index) const {
+  return this->output_tensors_[index].GetTensorData<float>();
+}
+
+const uint8_t *OnnxModel::ByteOutputData(size_t index) const {
+  return this->output_tensors_[index].GetTensorData<uint8_t>();
+}
+
+const std::vector<int64_t> &OnnxModel::OutputShape(size_t index) const {
+  return this->output_shapes_[index];
+}
+
+int64_t OnnxModel::OutputSize(size_t index) const {
+  const std::vector<int64_t> &shape = this->output_shapes_[index];
+  return std::accumulate(shape.begin(), shape.end(), int64_t(1),
+                         std::multiplies<int64_t>());
+}
+
+} // namespace PaddleOCR
@@ -13,37 +13,79 @@
 // limitations under the License.
 
 #include <include/args.h>
+#include <include/blocking_queue.h>
 #include <include/paddleocr.h>
 
 #include "auto_log/autolog.h"
 
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+
 namespace PaddleOCR {
 
 PPOCR::PPOCR() {
+  this->time_start = std::chrono::steady_clock::now();
+  // every model attaches to this env, so it must exist before any of them
+  OnnxModel::InitEnv(RuntimeProfile::FromFlags(""));
+
   if (FLAGS_det) {
     this->detector_ = new DBDetector(
         FLAGS_det_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
         FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_limit_type,
         FLAGS_limit_side_len, FLAGS_det_db_thresh, FLAGS_det_db_box_thresh,
         FLAGS_det_db_unclip_ratio, FLAGS_det_db_score_mode, FLAGS_use_dilation,
-        FLAGS_use_tensorrt, FLAGS_precision);
+        FLAGS_use_tensorrt, FLAGS_precision, FLAGS_det_fused_preprocess,
+        FLAGS_det_map_output, RuntimeProfile::FromFlags("det"));
   }
 
   if (FLAGS_cls && FLAGS_use_angle_cls) {
     this->classifier_ = new Classifier(
         FLAGS_cls_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
         FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_cls_thresh,
-        FLAGS_use_tensorrt, FLAGS_precision, FLAGS_cls_batch_num);
+        FLAGS_use_tensorrt, FLAGS_precision, FLAGS_cls_batch_num,
+        RuntimeProfile::FromFlags("cls"));
   }
   if (FLAGS_rec) {
     this->recognizer_ = new CRNNRecognizer(
         FLAGS_rec_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
         FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_rec_char_dict_path,
         FLAGS_use_tensorrt, FLAGS_precision, FLAGS_rec_batch_num,
-        FLAGS_rec_img_h, FLAGS_rec_img_w);
+        FLAGS_rec_img_h, FLAGS_rec_img_w, FLAGS_rec_batch_width,
+        FLAGS_rec_max_pad_ratio, FLAGS_rec_max_wh_ratio,
+        FLAGS_rec_chunk_overlap, RuntimeProfile::FromFlags("rec"));
   }
+
+  Worker worker;
+  worker.detector = this->detector_;
+  worker.classifier = this->classifier_;
+  worker.recognizer = this->recognizer_;
+  this->workers_.push_back(worker);
 };
 
+void PPOCR::add_workers(size_t num, bool det, bool cls) {
+  if (this->workers_.size() < num) {
+    this->workers_.resize(num);
+  }
+  // worker 0 has every model, the others get what was asked for so far
+  for (size_t i = 1; i < num; i++) {
+    Worker &worker = this->workers_[i];
+    if (det && worker.detector == nullptr && this->detector_ != nullptr) {
+      worker.detector = new DBDetector(*this->detector_);
+    }
+    if (cls && worker.classifier == nullptr && this->classifier_ != nullptr) {
+      worker.classifier = new Classifier(*this->classifier_);
+    }
+    if (worker.recognizer == nullptr && this->recognizer_ != nullptr) {
+      worker.recognizer = new CRNNRecognizer(*this->recognizer_);
+      // worker 0 already counts the batches run so far
+      worker.recognizer->ResetBatchStats();
+    }
+  }
+}
+
 std::vector<std::vector<OCRPredictResult>>
 PPOCR::ocr(std::vector<cv::Mat> img_list, bool det, bool rec, bool cls) {
   std::vector<std::vector<OCRPredictResult>> ocr_results;
@@ -68,11 +110,36 @@ PPOCR::ocr(std::vector<cv::Mat> img_list, bool det, bool rec, bool cls) {
       ocr_result_tmp.push_back(ocr_result[i]);
       ocr_results.push_back(ocr_result_tmp);
     }
+    this->first_result();
+  } else if (FLAGS_pipeline) {
+    ocr_results = this->ocr_pipeline(img_list, rec, cls);
   } else {
-    for (int i = 0; i < img_list.size(); ++i) {
-      std::vector<OCRPredictResult> ocr_result =
-          this->ocr(img_list[i], true, rec, cls);
-      ocr_results.push_back(ocr_result);
+    // pages go in groups of `rec_pool_pages` whose crops are recognized
+    // together, results land at their own index
+    size_t group = size_t(std::max(1, FLAGS_rec_pool_pages));
+    size_t num_groups = (img_list.size() + group - 1) / group;
+    size_t num = std::min(size_t(std::max(1, FLAGS_page_workers)), num_groups);
+    this->add_workers(num);
+    ocr_results.resize(img_list.size());
+    std::atomic<size_t> next_group(0);
+    auto work = [&](size_t w) {
+      for (size_t g = next_group++; g < num_groups; g = next_group++) {
+        size_t end = std::min(img_list.size(), (g + 1) * group);
+        this->ocr_pages(img_list, g * group, end, rec, cls, w, ocr_results);
+        std::lock_guard<std::mutex> lock(this->timer_mutex_);
+        this->first_result();
+      }
+    };
+    if (num == 1) {
+      work(0);
+    } else {
+      std::vector<std::thread> threads;
+      for (size_t w = 0; w < num; w++) {
+        threads.push_back(std::thread(work, w));
+      }
+      for (size_t w = 0; w < threads.size(); w++) {
+        threads[w].join();
+      }
     }
   }
   return ocr_results;
@@ -80,79 +147,397 @@ PPOCR::ocr(std::vector<cv::Mat> img_list, bool det, bool rec, bool cls) {
 
 std::vector<OCRPredictResult> PPOCR::ocr(cv::Mat img, bool det, bool rec,
                                          bool cls) {
+  return this->ocr_page(img, rec, cls, 0);
+}
 
-  std::vector<OCRPredictResult> ocr_result;
-  // det
-  this->det(img, ocr_result);
-  // crop image
+std::vector<OCRPredictResult> PPOCR::ocr_page(cv::Mat img, bool rec, bool cls,
+                                              size_t worker) {
+  // with --cls_after_rec_thresh cls only looks at the lines rec doubts
+  bool cls_after_rec = rec && FLAGS_cls_after_rec_thresh > 0;
   std::vector<cv::Mat> img_list;
-  for (int j = 0; j < ocr_result.size(); j++) {
-    cv::Mat crop_img;
-    crop_img = Utility::GetRotateCropImage(img, ocr_result[j].box);
-    img_list.push_back(crop_img);
+  std::vector<OCRPredictResult> ocr_result =
+      this->det_page(img, cls && !cls_after_rec, worker, img_list);
+  // rec
+  if (rec) {
+    this->rec(img_list, ocr_result, worker);
+  }
+  if (cls && cls_after_rec) {
+    this->cls_low_scores(img, img_list, ocr_result, worker);
+  }
+  return ocr_result;
+}
+
+void PPOCR::crop_boxes(const cv::Mat &img,
+                       const std::vector<OCRPredictResult> &results,
+                       std::vector<cv::Mat> &crops) {
+  // with --rec_direct_crop the crops come out of the warp at the rec
+  // height, and rec and cls read them without resizing them again
+  Utility::GetRotateCropImages(img, results, crops,
+                               FLAGS_rec_direct_crop ? FLAGS_rec_img_h : 0);
+}
+
+void PPOCR::cls_low_scores(const cv::Mat &img,
+                           const std::vector<cv::Mat> &crops,
+                           std::vector<OCRPredictResult> &results,
+                           size_t worker) {
+  const Worker &models = this->workers_[worker];
+  if (models.classifier == nullptr) {
+    return;
+  }
+  // lines rec could not read have a score of 0 and are checked too
+  std::vector<size_t> low;
+  std::vector<cv::Mat> low_crops;
+  for (size_t j = 0; j < results.size(); j++) {
+    if (results[j].score < FLAGS_cls_after_rec_thresh) {
+      low.push_back(j);
+      low_crops.push_back(crops[j]);
+    }
+  }
+  if (low.empty()) {
+    return;
+  }
+  std::vector<OCRPredictResult> low_results(low.size());
+  this->cls(low_crops, low_results, worker);
+
+  // indices into `low` of the lines cls would turn; their verdict only
+  // goes into the result if the turned line also reads better
+  std::vector<size_t> turned;
+  std::vector<cv::Mat> turned_crops;
+  for (size_t i = 0; i < low.size(); i++) {
+    const OCRPredictResult &verdict = low_results[i];
+    if (verdict.cls_label % 2 == 1 &&
+        verdict.cls_score > models.classifier->cls_thresh) {
+      cv::Mat crop = low_crops[i];
+      this->turn_crop(img, results[low[i]], crop);
+      turned.push_back(i);
+      turned_crops.push_back(crop);
+    } else {
+      // the line stays as it was read, which is what cls says
+      results[low[i]].cls_label = verdict.cls_label;
+      results[low[i]].cls_score = verdict.cls_score;
+    }
+  }
+  if (turned.empty()) {
+    return;
+  }
+  std::vector<OCRPredictResult> turned_results(turned.size());
+  this->rec(turned_crops, turned_results, worker);
+  for (size_t k = 0; k < turned.size(); k++) {
+    OCRPredictResult &result = results[low[turned[k]]];
+    if (turned_results[k].score > result.score) {
+      result.text = turned_results[k].text;
+      result.score = turned_results[k].score;
+      result.cls_label = low_results[turned[k]].cls_label;
+      result.cls_score = low_results[turned[k]].cls_score;
+    }
+  }
+}
+
+void PPOCR::cls_page(const std::vector<cv::Mat> &crops,
+                     std::vector<OCRPredictResult> &results, size_t worker) {
+  size_t num = crops.size();
+  size_t samples = size_t(std::max(0, FLAGS_cls_vote_samples));
+  if (samples == 0 || num <= samples) {
+    this->cls(crops, results, worker);
+    return;
   }
+  // The lines of a scanned page almost always share one orientation. Split
+  // the lines, sorted top to bottom, into `samples` runs and classify the
+  // widest crop of each, long lines classify most reliably. Their scores
+  // vote for their labels.
+  std::vector<size_t> picks;
+  std::vector<bool> picked(num, false);
+  for (size_t s = 0; s < samples; s++) {
+    size_t best = s * num / samples;
+    size_t end = (s + 1) * num / samples;
+    for (size_t i = best + 1; i < end; i++) {
+      if (float(crops[i].cols) / crops[i].rows >
+          float(crops[best].cols) / crops[best].rows) {
+        best = i;
+      }
+    }
+    picks.push_back(best);
+    picked[best] = true;
+  }
+  std::vector<cv::Mat> sample_crops;
+  for (size_t i = 0; i < picks.size(); i++) {
+    sample_crops.push_back(crops[picks[i]]);
+  }
+  std::vector<OCRPredictResult> sample_results(picks.size());
+  this->cls(sample_crops, sample_results, worker);
+
+  // weight and sum of scores of the samples that are upright (0) or turned
+  // (1), and a label of each
+  double weight[2] = {0, 0};
+  int votes[2] = {0, 0};
+  int label[2] = {0, 1};
+  for (size_t i = 0; i < sample_results.size(); i++) {
+    int turned = sample_results[i].cls_label % 2;
+    weight[turned] += sample_results[i].cls_score;
+    votes[turned]++;
+    label[turned] = sample_results[i].cls_label;
+  }
+  int winner = weight[1] > weight[0] ? 1 : 0;
+  double total = weight[0] + weight[1];
+  if (total > 0 && weight[winner] >= FLAGS_cls_vote_margin * total) {
+    float score = float(weight[winner] / votes[winner]);
+    for (size_t i = 0; i < num; i++) {
+      results[i].cls_label = label[winner];
+      results[i].cls_score = score;
+    }
+    return;
+  }
+
+  // no clear orientation: classify the remaining crops one by one
+  std::vector<cv::Mat> rest_crops;
+  std::vector<size_t> rest;
+  for (size_t i = 0; i < num; i++) {
+    if (!picked[i]) {
+      rest_crops.push_back(crops[i]);
+      rest.push_back(i);
+    }
+  }
+  std::vector<OCRPredictResult> rest_results(rest.size());
+  this->cls(rest_crops, rest_results, worker);
+  for (size_t i = 0; i < picks.size(); i++) {
+    results[picks[i]].cls_label = sample_results[i].cls_label;
+    results[picks[i]].cls_score = sample_results[i].cls_score;
+  }
+  for (size_t i = 0; i < rest.size(); i++) {
+    results[rest[i]].cls_label = rest_results[i].cls_label;
+    results[rest[i]].cls_score = rest_results[i].cls_score;
+  }
+}
+
+void PPOCR::turn_crop(const cv::Mat &img, const OCRPredictResult &result,
+                      cv::Mat &crop) {
+  if (FLAGS_rec_direct_crop) {
+    // warp the box again, turned, rather than resampling the crop
+    crop = Utility::GetRotateCropImage(img, Utility::BoxToQuad(result.box),
+                                       FLAGS_rec_img_h, true);
+    return;
+  }
+  // into a new Mat, a crop may be a view into the page
+  cv::Mat rotated;
+  cv::rotate(crop, rotated, 1);
+  crop = rotated;
+}
+
+std::vector<OCRPredictResult> PPOCR::det_page(const cv::Mat &img, bool cls,
+                                              size_t worker,
+                                              std::vector<cv::Mat> &img_list) {
+  const Worker &models = this->workers_[worker];
+  std::vector<OCRPredictResult> ocr_result;
+  // det
+  this->det(img, ocr_result, worker);
+  // crop image; `img_list` may already hold the crops of other pages
+  std::vector<cv::Mat> crop_list;
+  this->crop_boxes(img, ocr_result, crop_list);
   // cls
-  if (cls && this->classifier_ != nullptr) {
-    this->cls(img_list, ocr_result);
-    for (int i = 0; i < img_list.size(); i++) {
+  if (cls && models.classifier != nullptr) {
+    this->cls_page(crop_list, ocr_result, worker);
+    for (int i = 0; i < crop_list.size(); i++) {
       if (ocr_result[i].cls_label % 2 == 1 &&
-          ocr_result[i].cls_score > this->classifier_->cls_thresh) {
-        cv::rotate(img_list[i], img_list[i], 1);
+          ocr_result[i].cls_score > models.classifier->cls_thresh) {
+        this->turn_crop(img, ocr_result[i], crop_list[i]);
       }
     }
   }
-  // rec
-  if (rec) {
-    this->rec(img_list, ocr_result);
-  }
+  img_list.insert(img_list.end(), crop_list.begin(), crop_list.end());
   return ocr_result;
 }
 
-void PPOCR::det(cv::Mat img, std::vector<OCRPredictResult> &ocr_results) {
-  std::vector<std::vector<std::vector<int>>> boxes;
+void PPOCR::ocr_pages(const std::vector<cv::Mat> &img_list, size_t begin,
+                      size_t end, bool rec, bool cls, size_t worker,
+                      std::vector<std::vector<OCRPredictResult>> &ocr_results) {
+  if (end - begin == 1) {
+    ocr_results[begin] = this->ocr_page(img_list[begin], rec, cls, worker);
+    return;
+  }
+  // crops of all pages in one list, so the recognizer sorts them by width
+  // across pages and fills its batches even when every page has few lines
+  bool cls_after_rec = rec && FLAGS_cls_after_rec_thresh > 0;
+  std::vector<cv::Mat> crop_list;
+  for (size_t i = begin; i < end; i++) {
+    ocr_results[i] =
+        this->det_page(img_list[i], cls && !cls_after_rec, worker, crop_list);
+  }
+  if (!rec || crop_list.empty()) {
+    return;
+  }
+  std::vector<OCRPredictResult> crop_results(crop_list.size());
+  this->rec(crop_list, crop_results, worker);
+  size_t k = 0;
+  for (size_t i = begin; i < end; i++) {
+    size_t page_begin = k;
+    for (size_t j = 0; j < ocr_results[i].size(); j++, k++) {
+      ocr_results[i][j].text = crop_results[k].text;
+      ocr_results[i][j].score = crop_results[k].score;
+    }
+    if (cls && cls_after_rec) {
+      std::vector<cv::Mat> page_crops(crop_list.begin() + page_begin,
+                                      crop_list.begin() + k);
+      this->cls_low_scores(img_list[i], page_crops, ocr_results[i], worker);
+    }
+  }
+}
+
+std::vector<std::vector<OCRPredictResult>>
+PPOCR::ocr_pipeline(const std::vector<cv::Mat> &img_list, bool rec, bool cls) {
+  struct Page {
+    size_t index = 0;
+    std::vector<OCRPredictResult> result;
+    std::vector<cv::Mat> crops;
+  };
+  typedef std::unique_ptr<Page> PagePtr;
+  std::vector<std::vector<OCRPredictResult>> ocr_results(img_list.size());
+  // each model is only ever used by its own stage: det and cls run on the
+  // models of worker 0, rec thread i on those of worker i (cls too when it
+  // runs after rec), so the other workers only need those
+  bool cls_after_rec = rec && FLAGS_cls_after_rec_thresh > 0;
+  size_t rec_workers = size_t(std::max(1, FLAGS_pipeline_rec_workers));
+  this->add_workers(rec_workers, false, cls && cls_after_rec);
+  size_t queue_size = size_t(std::max(1, FLAGS_pipeline_queue_size));
+  BlockingQueue<PagePtr> crop_queue(queue_size);
+  BlockingQueue<PagePtr> cls_queue(queue_size);
+  BlockingQueue<PagePtr> rec_queue(queue_size);
+
+  // the first error of any stage cancels every queue, so the other stages
+  // stop as well, and is rethrown here once all threads are joined
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto stage = [&](const std::function<void()> &body) {
+    try {
+      body();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      crop_queue.Cancel();
+      cls_queue.Cancel();
+      rec_queue.Cancel();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.push_back(std::thread(stage, [&]() {
+    for (size_t i = 0; i < img_list.size(); i++) {
+      PagePtr page(new Page());
+      page->index = i;
+      this->det(img_list[i], page->result, 0);
+      if (!crop_queue.Push(std::move(page))) {
+        return;
+      }
+    }
+    crop_queue.Close();
+  }));
+  threads.push_back(std::thread(stage, [&]() {
+    PagePtr page;
+    while (crop_queue.Pop(page)) {
+      this->crop_boxes(img_list[page->index], page->result, page->crops);
+      if (!cls_queue.Push(std::move(page))) {
+        return;
+      }
+    }
+    cls_queue.Close();
+  }));
+  threads.push_back(std::thread(stage, [&]() {
+    PagePtr page;
+    while (cls_queue.Pop(page)) {
+      if (cls && !cls_after_rec && this->classifier_ != nullptr) {
+        this->cls_page(page->crops, page->result, 0);
+        for (size_t j = 0; j < page->crops.size(); j++) {
+          if (page->result[j].cls_label % 2 == 1 &&
+              page->result[j].cls_score > this->classifier_->cls_thresh) {
+            this->turn_crop(img_list[page->index], page->result[j],
+                            page->crops[j]);
+          }
+        }
+      }
+      if (!rec_queue.Push(std::move(page))) {
+        return;
+      }
+    }
+    rec_queue.Close();
+  }));
+  for (size_t w = 0; w < rec_workers; w++) {
+    threads.push_back(std::thread(stage, [&, w]() {
+      PagePtr page;
+      while (rec_queue.Pop(page)) {
+        if (rec) {
+          this->rec(page->crops, page->result, w);
+        }
+        if (cls && cls_after_rec) {
+          this->cls_low_scores(img_list[page->index], page->crops,
+                               page->result, w);
+        }
+        ocr_results[page->index] = std::move(page->result);
+        std::lock_guard<std::mutex> lock(this->timer_mutex_);
+        this->first_result();
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return ocr_results;
+}
+
+void PPOCR::det(cv::Mat img, std::vector<OCRPredictResult> &ocr_results,
+                size_t worker) {
+  std::vector<Quad> boxes;
   std::vector<double> det_times;
 
-  this->detector_->Run(img, boxes, det_times);
+  this->workers_[worker].detector->Run(img, boxes, det_times);
 
+  // sort boex from top to bottom, from left to right
+  Utility::sorted_boxes(boxes);
+  // results carry their box as nested vectors, built once per kept box
   for (int i = 0; i < boxes.size(); i++) {
     OCRPredictResult res;
-    res.box = boxes[i];
+    res.box = Utility::QuadToBox(boxes[i]);
     ocr_results.push_back(res);
   }
-  // sort boex from top to bottom, from left to right
-  Utility::sorted_boxes(ocr_results);
+  std::lock_guard<std::mutex> lock(this->timer_mutex_);
   this->time_info_det[0] += det_times[0];
   this->time_info_det[1] += det_times[1];
   this->time_info_det[2] += det_times[2];
 }
 
 void PPOCR::rec(std::vector<cv::Mat> img_list,
-                std::vector<OCRPredictResult> &ocr_results) {
+                std::vector<OCRPredictResult> &ocr_results, size_t worker) {
   std::vector<std::string> rec_texts(img_list.size(), "");
   std::vector<float> rec_text_scores(img_list.size(), 0);
   std::vector<double> rec_times;
-  this->recognizer_->Run(img_list, rec_texts, rec_text_scores, rec_times);
+  this->workers_[worker].recognizer->Run(img_list, rec_texts, rec_text_scores,
+                                         rec_times);
   // output rec results
   for (int i = 0; i < rec_texts.size(); i++) {
     ocr_results[i].text = rec_texts[i];
     ocr_results[i].score = rec_text_scores[i];
   }
+  std::lock_guard<std::mutex> lock(this->timer_mutex_);
   this->time_info_rec[0] += rec_times[0];
   this->time_info_rec[1] += rec_times[1];
   this->time_info_rec[2] += rec_times[2];
 }
 
 void PPOCR::cls(std::vector<cv::Mat> img_list,
-                std::vector<OCRPredictResult> &ocr_results) {
+                std::vector<OCRPredictResult> &ocr_results, size_t worker) {
   std::vector<int> cls_labels(img_list.size(), 0);
   std::vector<float> cls_scores(img_list.size(), 0);
   std::vector<double> cls_times;
-  this->classifier_->Run(img_list, cls_labels, cls_scores, cls_times);
+  this->workers_[worker].classifier->Run(img_list, cls_labels, cls_scores,
+                                         cls_times);
   // output cls results
   for (int i = 0; i < cls_labels.size(); i++) {
     ocr_results[i].cls_label = cls_labels[i];
     ocr_results[i].cls_score = cls_scores[i];
   }
+  std::lock_guard<std::mutex> lock(this->timer_mutex_);
   this->time_info_cls[0] += cls_times[0];
   this->time_info_cls[1] += cls_times[1];
   this->time_info_cls[2] += cls_times[2];
@@ -162,9 +547,76 @@ void PPOCR::reset_timer() {
   this->time_info_det = {0, 0, 0};
   this->time_info_rec = {0, 0, 0};
   this->time_info_cls = {0, 0, 0};
+  for (size_t i = 0; i < this->workers_.size(); i++) {
+    if (this->workers_[i].recognizer != nullptr) {
+      this->workers_[i].recognizer->ResetBatchStats();
+    }
+  }
+}
+
+void PPOCR::rec_batch_log() {
+  RecBatchStats stats;
+  for (size_t i = 0; i < this->workers_.size(); i++) {
+    if (this->workers_[i].recognizer != nullptr) {
+      stats.Merge(this->workers_[i].recognizer->BatchStats());
+    }
+  }
+  if (stats.padded_cols <= 0) {
+    return;
+  }
+  std::cout << "rec batches (size x width: count):";
+  for (auto it = stats.shapes.begin(); it != stats.shapes.end(); it++) {
+    std::cout << " " << it->first.first << "x" << it->first.second << ": "
+              << it->second;
+  }
+  std::cout << std::endl;
+  std::cout << "rec padding waste: "
+            << 100 * (1 - stats.valid_cols / stats.padded_cols) << "%"
+            << std::endl;
+}
+
+void PPOCR::first_result() {
+  if (this->time_to_first_result < 0) {
+    std::chrono::duration<float> diff =
+        std::chrono::steady_clock::now() - this->time_start;
+    this->time_to_first_result = double(diff.count() * 1000);
+  }
+}
+
+std::map<std::string, double> PPOCR::load_times() {
+  std::map<std::string, double> res;
+  if (this->detector_ != nullptr) {
+    res["det"] = this->detector_->LoadTime();
+  }
+  if (this->classifier_ != nullptr) {
+    res["cls"] = this->classifier_->LoadTime();
+  }
+  if (this->recognizer_ != nullptr) {
+    res["rec"] = this->recognizer_->LoadTime();
+  }
+  return res;
+}
+
+void PPOCR::load_log(const std::map<std::string, double> &load_times) {
+  std::cout << "model load time (" << FLAGS_model_load_mode << "):";
+  for (auto it = load_times.begin(); it != load_times.end(); it++) {
+    std::cout << " " << it->first;
+    if (it->second > 0) {
+      std::cout << " " << it->second << " ms";
+    } else {
+      std::cout << " not loaded";
+    }
+  }
+  std::cout << std::endl;
+  if (this->time_to_first_result >= 0) {
+    std::cout << "time to first result: " << this->time_to_first_result
+              << " ms" << (FLAGS_model_cache ? " (model_cache on)" : "")
+              << std::endl;
+  }
 }
 
 void PPOCR::benchmark_log(int img_num) {
+  this->load_log(this->load_times());
   if (this->time_info_det[0] + this->time_info_det[1] + this->time_info_det[2] >
       0) {
     AutoLogger autolog_det("ocr_det", FLAGS_use_gpu, FLAGS_use_tensorrt,
@@ -179,6 +631,7 @@ void PPOCR::benchmark_log(int img_num) {
                            FLAGS_rec_batch_num, "dynamic", FLAGS_precision,
                            this->time_info_rec, img_num);
     autolog_rec.report();
+    this->rec_batch_log();
   }
   if (this->time_info_cls[0] + this->time_info_cls[1] + this->time_info_cls[2] >
       0) {
@@ -191,6 +644,11 @@ void PPOCR::benchmark_log(int img_num) {
 }
 
 PPOCR::~PPOCR() {
+  for (size_t i = 1; i < this->workers_.size(); i++) {
+    delete this->workers_[i].detector;
+    delete this->workers_[i].classifier;
+    delete this->workers_[i].recognizer;
+  }
   if (this->detector_ != nullptr) {
     delete this->detector_;
   }
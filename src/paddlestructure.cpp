@@ -25,14 +25,15 @@ PaddleStructure::PaddleStructure() {
         FLAGS_layout_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
         FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_layout_dict_path,
         FLAGS_use_tensorrt, FLAGS_precision, FLAGS_layout_score_threshold,
-        FLAGS_layout_nms_threshold);
+        FLAGS_layout_nms_threshold, RuntimeProfile::FromFlags("layout"));
   }
   if (FLAGS_table) {
     this->table_model_ = new StructureTableRecognizer(
         FLAGS_table_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
         FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_table_char_dict_path,
         FLAGS_use_tensorrt, FLAGS_precision, FLAGS_table_batch_num,
-        FLAGS_table_max_len, FLAGS_merge_no_span_structure);
+        FLAGS_table_max_len, FLAGS_merge_no_span_structure,
+        RuntimeProfile::FromFlags("table"));
   }
 };
 
@@ -64,6 +65,7 @@ PaddleStructure::structure(cv::Mat srcimg, bool layout, bool table, bool ocr) {
     }
   }
 
+  this->first_result();
   return structure_results;
 };
 
@@ -244,6 +246,14 @@ void PaddleStructure::reset_timer() {
 }
 
 void PaddleStructure::benchmark_log(int img_num) {
+  std::map<std::string, double> load_times = this->load_times();
+  if (this->layout_model_ != nullptr) {
+    load_times["layout"] = this->layout_model_->LoadTime();
+  }
+  if (this->table_model_ != nullptr) {
+    load_times["table"] = this->table_model_->LoadTime();
+  }
+  this->load_log(load_times);
   if (this->time_info_det[0] + this->time_info_det[1] + this->time_info_det[2] >
       0) {
     AutoLogger autolog_det("ocr_det", FLAGS_use_gpu, FLAGS_use_tensorrt,
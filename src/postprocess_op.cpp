@@ -16,8 +16,8 @@
 
 namespace PaddleOCR {
 
-void DBPostProcessor::GetContourArea(const std::vector<std::vector<float>> &box,
-                                     float unclip_ratio, float &distance) {
+void DBPostProcessor::GetContourArea(const QuadF &box, float unclip_ratio,
+                                     float &distance) {
   int pts_num = 4;
   float area = 0.0f;
   float dist = 0.0f;
@@ -34,8 +34,36 @@ void DBPostProcessor::GetContourArea(const std::vector<std::vector<float>> &box,
   distance = area * unclip_ratio / dist;
 }
 
-cv::RotatedRect DBPostProcessor::UnClip(std::vector<std::vector<float>> box,
+cv::RotatedRect DBPostProcessor::UnClip(const QuadF &box,
                                         const float &unclip_ratio) {
+  // Offsetting a rectangle by `distance` with round joins gives the same
+  // rectangle grown by `distance` on every side with rounded corners, whose
+  // min area rect is that grown rectangle.
+  cv::Point2f p0(box[0][0], box[0][1]);
+  cv::Point2f p1(box[1][0], box[1][1]);
+  cv::Point2f p2(box[2][0], box[2][1]);
+  cv::Point2f p3(box[3][0], box[3][1]);
+  cv::Point2f e0 = p1 - p0;
+  cv::Point2f e1 = p2 - p1;
+  float w = std::sqrt(e0.dot(e0));
+  float h = std::sqrt(e1.dot(e1));
+  // a rectangle: the cosine between adjacent sides within 0.01, and
+  // opposite sides equal as vectors within 1% of the shorter side
+  cv::Point2f diag = (p0 + p2) - (p1 + p3);
+  if (w <= 0 || h <= 0 || std::fabs(e0.dot(e1)) > 0.01f * w * h ||
+      std::sqrt(diag.dot(diag)) > 0.01f * std::min(w, h)) {
+    return UnClipPolygon(box, unclip_ratio);
+  }
+  float distance = 1.0;
+  GetContourArea(box, unclip_ratio, distance);
+  cv::Point2f center = (p0 + p1 + p2 + p3) * 0.25f;
+  float angle = std::atan2(e0.y, e0.x) * float(180 / CV_PI);
+  return cv::RotatedRect(center,
+                         cv::Size2f(w + 2 * distance, h + 2 * distance), angle);
+}
+
+cv::RotatedRect DBPostProcessor::UnClipPolygon(const QuadF &box,
+                                               const float &unclip_ratio) {
   float distance = 1.0;
 
   GetContourArea(box, unclip_ratio, distance);
@@ -79,174 +107,327 @@ float **DBPostProcessor::Mat2Vec(cv::Mat mat) {
   return array;
 }
 
-std::vector<std::vector<int>>
-DBPostProcessor::OrderPointsClockwise(std::vector<std::vector<int>> pts) {
-  std::vector<std::vector<int>> box = pts;
-  std::sort(box.begin(), box.end(), XsortInt);
+namespace {
 
-  std::vector<std::vector<int>> leftmost = {box[0], box[1]};
-  std::vector<std::vector<int>> rightmost = {box[2], box[3]};
+// Corner indices of `box` by increasing x, ties kept in corner order.
+template <class T> void SortByX(const QuadT<T> &box, int order[4]) {
+  for (int i = 0; i < 4; i++) {
+    int k = i;
+    for (; k > 0 && box[order[k - 1]][0] > box[i][0]; k--) {
+      order[k] = order[k - 1];
+    }
+    order[k] = i;
+  }
+}
 
-  if (leftmost[0][1] > leftmost[1][1])
-    std::swap(leftmost[0], leftmost[1]);
+} // namespace
 
-  if (rightmost[0][1] > rightmost[1][1])
-    std::swap(rightmost[0], rightmost[1]);
+Quad DBPostProcessor::OrderPointsClockwise(const Quad &pts) {
+  int order[4];
+  SortByX(pts, order);
 
-  std::vector<std::vector<int>> rect = {leftmost[0], rightmost[0], rightmost[1],
-                                        leftmost[1]};
-  return rect;
-}
+  // of the two leftmost and the two rightmost corners, the upper one first
+  int left0 = order[0], left1 = order[1];
+  int right0 = order[2], right1 = order[3];
+  if (pts[left0][1] > pts[left1][1])
+    std::swap(left0, left1);
 
-std::vector<std::vector<float>> DBPostProcessor::Mat2Vector(cv::Mat mat) {
-  std::vector<std::vector<float>> img_vec;
-  std::vector<float> tmp;
+  if (pts[right0][1] > pts[right1][1])
+    std::swap(right0, right1);
 
-  for (int i = 0; i < mat.rows; ++i) {
-    tmp.clear();
-    for (int j = 0; j < mat.cols; ++j) {
-      tmp.push_back(mat.at<float>(i, j));
-    }
-    img_vec.push_back(tmp);
+  Quad rect;
+  const int corners[4] = {left0, right0, right1, left1};
+  for (int i = 0; i < 4; i++) {
+    rect[i][0] = pts[corners[i]][0];
+    rect[i][1] = pts[corners[i]][1];
   }
-  return img_vec;
-}
-
-bool DBPostProcessor::XsortFp32(std::vector<float> a, std::vector<float> b) {
-  if (a[0] != b[0])
-    return a[0] < b[0];
-  return false;
-}
-
-bool DBPostProcessor::XsortInt(std::vector<int> a, std::vector<int> b) {
-  if (a[0] != b[0])
-    return a[0] < b[0];
-  return false;
+  return rect;
 }
 
-std::vector<std::vector<float>>
-DBPostProcessor::GetMiniBoxes(cv::RotatedRect box, float &ssid) {
+QuadF DBPostProcessor::GetMiniBoxes(cv::RotatedRect box, float &ssid) {
   ssid = std::max(box.size.width, box.size.height);
 
-  cv::Mat points;
-  cv::boxPoints(box, points);
+  cv::Point2f points[4];
+  box.points(points);
 
-  auto array = Mat2Vector(points);
-  std::sort(array.begin(), array.end(), XsortFp32);
+  QuadF array;
+  for (int i = 0; i < 4; i++) {
+    array[i][0] = points[i].x;
+    array[i][1] = points[i].y;
+  }
+  int order[4];
+  SortByX(array, order);
 
-  std::vector<float> idx1 = array[0], idx2 = array[1], idx3 = array[2],
-                     idx4 = array[3];
-  if (array[3][1] <= array[2][1]) {
-    idx2 = array[3];
-    idx3 = array[2];
+  int idx1, idx2, idx3, idx4;
+  if (array[order[3]][1] <= array[order[2]][1]) {
+    idx2 = order[3];
+    idx3 = order[2];
   } else {
-    idx2 = array[2];
-    idx3 = array[3];
+    idx2 = order[2];
+    idx3 = order[3];
   }
-  if (array[1][1] <= array[0][1]) {
-    idx1 = array[1];
-    idx4 = array[0];
+  if (array[order[1]][1] <= array[order[0]][1]) {
+    idx1 = order[1];
+    idx4 = order[0];
   } else {
-    idx1 = array[0];
-    idx4 = array[1];
+    idx1 = order[0];
+    idx4 = order[1];
   }
 
-  array[0] = idx1;
-  array[1] = idx2;
-  array[2] = idx3;
-  array[3] = idx4;
+  QuadF mini_box;
+  const int corners[4] = {idx1, idx2, idx3, idx4};
+  for (int i = 0; i < 4; i++) {
+    mini_box[i][0] = array[corners[i]][0];
+    mini_box[i][1] = array[corners[i]][1];
+  }
+  return mini_box;
+}
 
-  return array;
+namespace {
+
+// crossings of one row that fit on the stack
+const int kMaxCrossings = 64;
+
+// Whether the bottom end of edge `i` (pts[i] -> pts[i + 1]) is a local
+// maximum of the outline, i.e. the outline turns back up there, possibly
+// after a horizontal stretch.
+bool BottomIsTurn(const cv::Point *pts, int n, int i) {
+  const cv::Point &p = pts[i];
+  const cv::Point &q = pts[(i + 1) % n];
+  if (q.y > p.y) {
+    // walk forward from q to the next edge that is not horizontal
+    for (int k = (i + 1) % n, steps = 0; steps < n; k = (k + 1) % n, steps++) {
+      int dy = pts[(k + 1) % n].y - pts[k].y;
+      if (dy != 0) {
+        return dy < 0;
+      }
+    }
+  } else {
+    // walk backward from p to the previous edge that is not horizontal
+    for (int k = i, steps = 0; steps < n; k = (k + n - 1) % n, steps++) {
+      int dy = pts[k].y - pts[(k + n - 1) % n].y;
+      if (dy != 0) {
+        return dy > 0;
+      }
+    }
+  }
+  return false;
 }
 
-float DBPostProcessor::PolygonScoreAcc(std::vector<cv::Point> contour,
-                                       cv::Mat pred) {
-  int width = pred.cols;
-  int height = pred.rows;
-  std::vector<float> box_x;
-  std::vector<float> box_y;
-  for (int i = 0; i < contour.size(); ++i) {
-    box_x.push_back(contour[i].x);
-    box_y.push_back(contour[i].y);
-  }
-
-  int xmin =
-      clamp(int(std::floor(*(std::min_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int xmax =
-      clamp(int(std::ceil(*(std::max_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int ymin =
-      clamp(int(std::floor(*(std::min_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
-  int ymax =
-      clamp(int(std::ceil(*(std::max_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
+// Insert a crossing into the sorted pos/delta lists of size m, rows rarely
+// have more than a few crossings.
+inline void AddCrossing(int *pos, int *delta, int &m, int x, int d) {
+  int k = m++;
+  for (; k > 0 && pos[k - 1] > x; k--) {
+    pos[k] = pos[k - 1];
+    delta[k] = delta[k - 1];
+  }
+  pos[k] = x;
+  delta[k] = d;
+}
 
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
+// Call span(y, a, b) for every row y of the polygon and every run [a, b) of
+// columns in it, clipped to `width` x `height`. As with fillPoly the outline
+// itself is inside: a run goes from the ceil of where the row enters to the
+// floor of where it leaves, and horizontal edges are a run of their own.
+// Whether a crossing enters or leaves follows from the direction of its
+// edge and the orientation of the polygon, so the crossings of a row only
+// need sorting, runs are where the winding number is not 0. Crossings are
+// computed in integers, pixel centers exactly on an edge count as inside.
+// This is the pixel set of fillPoly as long as every edge is horizontal,
+// vertical or diagonal, as in findContours output; fillPoly draws other
+// edges as 8-connected lines, which reach a few pixels further out.
+// False, without calling span, for polygons of zero area or rows with more
+// than kMaxCrossings crossings.
+template <class Span>
+bool PolygonSpans(const cv::Point *pts, int n, int width, int height,
+                  Span span) {
+  if (n < 3) {
+    return false;
+  }
+  long long area2 = 0;
+  int ymin = pts[0].y;
+  int ymax = pts[0].y;
+  for (int i = 0; i < n; i++) {
+    const cv::Point &p = pts[i];
+    const cv::Point &q = pts[(i + 1) % n];
+    area2 += (long long)p.x * q.y - (long long)q.x * p.y;
+    ymin = std::min(ymin, p.y);
+    ymax = std::max(ymax, p.y);
+  }
+  if (area2 == 0) {
+    return false;
+  }
+  // with y pointing down and a positive area, edges going down leave
+  const bool down_leaves = area2 > 0;
+  int pos[kMaxCrossings];
+  int delta[kMaxCrossings];
+  for (int y = std::max(ymin, 0); y <= std::min(ymax, height - 1); y++) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+      const cv::Point &p = pts[i];
+      const cv::Point &q = pts[(i + 1) % n];
+      if (p.y == q.y) {
+        // a horizontal edge in this row is inside as a whole
+        if (p.y == y) {
+          if (m + 2 > kMaxCrossings) {
+            return false;
+          }
+          AddCrossing(pos, delta, m, std::min(p.x, q.x), 1);
+          AddCrossing(pos, delta, m, std::max(p.x, q.x) + 1, -1);
+        }
+        continue;
+      }
+      if (y < std::min(p.y, q.y) || y > std::max(p.y, q.y)) {
+        continue;
+      }
+      // a vertex the outline passes through counts once, a bottom turn
+      // twice (leaving right where it enters)
+      if (y == std::max(p.y, q.y) && !BottomIsTurn(pts, n, i)) {
+        continue;
+      }
+      if (m == kMaxCrossings) {
+        return false;
+      }
+      // x = p.x + num / den exactly, rounded in integers
+      long long num = (long long)(y - p.y) * (q.x - p.x);
+      long long den = q.y - p.y;
+      if (den < 0) {
+        num = -num;
+        den = -den;
+      }
+      long long floor_div = num >= 0 ? num / den : -((-num + den - 1) / den);
+      if ((q.y > p.y) == down_leaves) {
+        AddCrossing(pos, delta, m, p.x + int(floor_div) + 1, -1);
+      } else {
+        AddCrossing(pos, delta, m,
+                    p.x + int(floor_div) + (floor_div * den != num ? 1 : 0),
+                    1);
+      }
+    }
+    int winding = 0;
+    for (int k = 0; k < m; k++) {
+      if (k > 0 && winding != 0 && pos[k] > pos[k - 1]) {
+        int a = std::min(std::max(pos[k - 1], 0), width);
+        int b = std::min(std::max(pos[k], 0), width);
+        if (b > a) {
+          span(y, a, b);
+        }
+      }
+      winding += delta[k];
+    }
+  }
+  return true;
+}
+
+// Mean of `pred` over the polygon, summing each run of a row in place.
+template <class T>
+bool SpanMean(const cv::Point *pts, int n, const cv::Mat &pred, double &mean) {
+  double sum = 0;
+  long long count = 0;
+  bool ok = PolygonSpans(pts, n, pred.cols, pred.rows,
+                         [&](int y, int a, int b) {
+                           const T *row = pred.ptr<T>(y);
+                           for (int x = a; x < b; x++) {
+                             sum += row[x];
+                           }
+                           count += b - a;
+                         });
+  mean = count > 0 ? sum / count : 0;
+  return ok;
+}
 
-  cv::Point *rook_point = new cv::Point[contour.size()];
+} // namespace
 
-  for (int i = 0; i < contour.size(); ++i) {
-    rook_point[i] = cv::Point(int(box_x[i]) - xmin, int(box_y[i]) - ymin);
+float DBPostProcessor::PolygonScore(const cv::Point *pts, int n,
+                                    const cv::Mat &pred) {
+  double mean = 0;
+  bool ok = pred.depth() == CV_8U ? SpanMean<uchar>(pts, n, pred, mean)
+                                  : SpanMean<float>(pts, n, pred, mean);
+  if (!ok) {
+    return MaskScore(pts, n, pred);
   }
-  const cv::Point *ppt[1] = {rook_point};
-  int npt[] = {int(contour.size())};
-
-  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
+  // a uint8 map holds the probability times 255
+  return float(pred.depth() == CV_8U ? mean / 255 : mean);
+}
 
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
-  float score = cv::mean(croppedImg, mask)[0];
+void DBPostProcessor::RowSums(const cv::Mat &pred, cv::Mat &sums) {
+  cv::integral(pred, sums, CV_64F);
+}
 
-  delete[] rook_point;
-  return score;
+float DBPostProcessor::PolygonScore(const cv::Point *pts, int n,
+                                    const cv::Mat &pred, const cv::Mat &sums) {
+  // the sum of row y over [a, b) is a difference of the integral image in
+  // rows y and y + 1
+  double sum = 0;
+  long long count = 0;
+  bool ok = PolygonSpans(pts, n, pred.cols, pred.rows,
+                         [&](int y, int a, int b) {
+                           const double *s0 = sums.ptr<double>(y);
+                           const double *s1 = sums.ptr<double>(y + 1);
+                           sum += (s1[b] - s1[a]) - (s0[b] - s0[a]);
+                           count += b - a;
+                         });
+  if (!ok) {
+    return MaskScore(pts, n, pred);
+  }
+  double mean = count > 0 ? sum / count : 0;
+  return float(pred.depth() == CV_8U ? mean / 255 : mean);
 }
 
-float DBPostProcessor::BoxScoreFast(std::vector<std::vector<float>> box_array,
-                                    cv::Mat pred) {
-  auto array = box_array;
+float DBPostProcessor::MaskScore(const cv::Point *pts, int n,
+                                 const cv::Mat &pred) {
   int width = pred.cols;
   int height = pred.rows;
-
-  float box_x[4] = {array[0][0], array[1][0], array[2][0], array[3][0]};
-  float box_y[4] = {array[0][1], array[1][1], array[2][1], array[3][1]};
-
-  int xmin = clamp(int(std::floor(*(std::min_element(box_x, box_x + 4)))), 0,
-                   width - 1);
-  int xmax = clamp(int(std::ceil(*(std::max_element(box_x, box_x + 4)))), 0,
-                   width - 1);
-  int ymin = clamp(int(std::floor(*(std::min_element(box_y, box_y + 4)))), 0,
-                   height - 1);
-  int ymax = clamp(int(std::ceil(*(std::max_element(box_y, box_y + 4)))), 0,
-                   height - 1);
+  int xmin = width - 1, xmax = 0, ymin = height - 1, ymax = 0;
+  for (int i = 0; i < n; ++i) {
+    xmin = std::min(xmin, pts[i].x);
+    xmax = std::max(xmax, pts[i].x);
+    ymin = std::min(ymin, pts[i].y);
+    ymax = std::max(ymax, pts[i].y);
+  }
+  xmin = clamp(xmin, 0, width - 1);
+  xmax = clamp(xmax, 0, width - 1);
+  ymin = clamp(ymin, 0, height - 1);
+  ymax = clamp(ymax, 0, height - 1);
 
   cv::Mat mask;
   mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
-
-  cv::Point root_point[4];
-  root_point[0] = cv::Point(int(array[0][0]) - xmin, int(array[0][1]) - ymin);
-  root_point[1] = cv::Point(int(array[1][0]) - xmin, int(array[1][1]) - ymin);
-  root_point[2] = cv::Point(int(array[2][0]) - xmin, int(array[2][1]) - ymin);
-  root_point[3] = cv::Point(int(array[3][0]) - xmin, int(array[3][1]) - ymin);
-  const cv::Point *ppt[1] = {root_point};
-  int npt[] = {4};
-  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
+  const cv::Point *ppt[1] = {pts};
+  int npt[] = {n};
+  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1), cv::LINE_8, 0,
+               cv::Point(-xmin, -ymin));
 
   cv::Mat croppedImg;
   pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
       .copyTo(croppedImg);
-
-  auto score = cv::mean(croppedImg, mask)[0];
+  float score = cv::mean(croppedImg, mask)[0];
+  // a uint8 map holds the probability times 255
+  if (pred.depth() == CV_8U) {
+    score /= 255;
+  }
   return score;
 }
 
-std::vector<std::vector<std::vector<int>>> DBPostProcessor::BoxesFromBitmap(
+float DBPostProcessor::PolygonScoreAcc(const std::vector<cv::Point> &contour,
+                                       const cv::Mat &pred) {
+  return PolygonScore(contour.data(), int(contour.size()), pred);
+}
+
+float DBPostProcessor::BoxScoreFast(const QuadF &box_array,
+                                    const cv::Mat &pred) {
+  // corners truncated to int; the edges of a rotated box are slanted, where
+  // fillPoly sets more pixels than the spans, so this keeps the mask
+  cv::Point pts[4];
+  for (int i = 0; i < 4; i++) {
+    pts[i] = cv::Point(int(box_array[i][0]), int(box_array[i][1]));
+  }
+  return MaskScore(pts, 4, pred);
+}
+
+std::vector<Quad> DBPostProcessor::BoxesFromBitmap(
     const cv::Mat pred, const cv::Mat bitmap, const float &box_thresh,
     const float &det_db_unclip_ratio, const std::string &det_db_score_mode) {
-  const int min_size = 3;
   const int max_candidates = 1000;
 
   int width = bitmap.cols;
@@ -261,75 +442,101 @@ std::vector<std::vector<std::vector<int>>> DBPostProcessor::BoxesFromBitmap(
   int num_contours =
       contours.size() >= max_candidates ? max_candidates : contours.size();
 
-  std::vector<std::vector<std::vector<int>>> boxes;
+  // Contours are independent: each one gets its own slot, filled in
+  // parallel, and the slots are collected in contour order afterwards, so
+  // the boxes come out exactly as in a serial loop.
+  std::vector<Quad> slots(num_contours);
+  std::vector<char> found(num_contours, 0);
+  auto body = [&](const cv::Range &range) {
+    for (int _i = range.start; _i < range.end; _i++) {
+      found[_i] = this->BoxFromContour(contours[_i], pred, width, height,
+                                       box_thresh, det_db_unclip_ratio,
+                                       det_db_score_mode, slots[_i]);
+    }
+  };
+  // a handful of contours is not worth waking up the pool
+  if (num_contours >= 32) {
+    cv::parallel_for_(cv::Range(0, num_contours), body, num_contours / 16.);
+  } else {
+    body(cv::Range(0, num_contours));
+  }
 
+  std::vector<Quad> boxes;
   for (int _i = 0; _i < num_contours; _i++) {
-    if (contours[_i].size() <= 2) {
-      continue;
+    if (found[_i]) {
+      boxes.push_back(slots[_i]);
     }
-    float ssid;
-    cv::RotatedRect box = cv::minAreaRect(contours[_i]);
-    auto array = GetMiniBoxes(box, ssid);
+  }
+  return boxes;
+}
 
-    auto box_for_unclip = array;
-    // end get_mini_box
+bool DBPostProcessor::BoxFromContour(const std::vector<cv::Point> &contour,
+                                     const cv::Mat &pred, int width,
+                                     int height, const float &box_thresh,
+                                     const float &det_db_unclip_ratio,
+                                     const std::string &det_db_score_mode,
+                                     Quad &box_out) {
+  const int min_size = 3;
+  if (contour.size() <= 2) {
+    return false;
+  }
+  float ssid;
+  cv::RotatedRect box = cv::minAreaRect(contour);
+  auto array = GetMiniBoxes(box, ssid);
 
-    if (ssid < min_size) {
-      continue;
-    }
+  // end get_mini_box
 
-    float score;
-    if (det_db_score_mode == "slow")
-      /* compute using polygon*/
-      score = PolygonScoreAcc(contours[_i], pred);
-    else
-      score = BoxScoreFast(array, pred);
+  if (ssid < min_size) {
+    return false;
+  }
 
-    if (score < box_thresh)
-      continue;
+  float score;
+  if (det_db_score_mode == "slow")
+    /* compute using polygon*/
+    score = PolygonScoreAcc(contour, pred);
+  else
+    score = BoxScoreFast(array, pred);
 
-    // start for unclip
-    cv::RotatedRect points = UnClip(box_for_unclip, det_db_unclip_ratio);
-    if (points.size.height < 1.001 && points.size.width < 1.001) {
-      continue;
-    }
-    // end for unclip
+  if (score < box_thresh)
+    return false;
 
-    cv::RotatedRect clipbox = points;
-    auto cliparray = GetMiniBoxes(clipbox, ssid);
+  // start for unclip
+  cv::RotatedRect points = UnClip(array, det_db_unclip_ratio);
+  if (points.size.height < 1.001 && points.size.width < 1.001) {
+    return false;
+  }
+  // end for unclip
 
-    if (ssid < min_size + 2)
-      continue;
+  cv::RotatedRect clipbox = points;
+  auto cliparray = GetMiniBoxes(clipbox, ssid);
 
-    int dest_width = pred.cols;
-    int dest_height = pred.rows;
-    std::vector<std::vector<int>> intcliparray;
-
-    for (int num_pt = 0; num_pt < 4; num_pt++) {
-      std::vector<int> a{int(clampf(roundf(cliparray[num_pt][0] / float(width) *
-                                           float(dest_width)),
-                                    0, float(dest_width))),
-                         int(clampf(roundf(cliparray[num_pt][1] /
-                                           float(height) * float(dest_height)),
-                                    0, float(dest_height)))};
-      intcliparray.push_back(a);
-    }
-    boxes.push_back(intcliparray);
+  if (ssid < min_size + 2)
+    return false;
 
-  } // end for
-  return boxes;
+  int dest_width = pred.cols;
+  int dest_height = pred.rows;
+
+  for (int num_pt = 0; num_pt < 4; num_pt++) {
+    box_out[num_pt][0] = int(clampf(
+        roundf(cliparray[num_pt][0] / float(width) * float(dest_width)), 0,
+        float(dest_width)));
+    box_out[num_pt][1] = int(clampf(
+        roundf(cliparray[num_pt][1] / float(height) * float(dest_height)), 0,
+        float(dest_height)));
+  }
+  return true;
 }
 
-std::vector<std::vector<std::vector<int>>> DBPostProcessor::FilterTagDetRes(
-    std::vector<std::vector<std::vector<int>>> boxes, float ratio_h,
-    float ratio_w, cv::Mat srcimg) {
+std::vector<Quad> DBPostProcessor::FilterTagDetRes(std::vector<Quad> boxes,
+                                                   float ratio_h, float ratio_w,
+                                                   cv::Mat srcimg) {
   int oriimg_h = srcimg.rows;
   int oriimg_w = srcimg.cols;
 
-  std::vector<std::vector<std::vector<int>>> root_points;
+  std::vector<Quad> root_points;
   for (int n = 0; n < boxes.size(); n++) {
     boxes[n] = OrderPointsClockwise(boxes[n]);
-    for (int m = 0; m < boxes[0].size(); m++) {
+    for (int m = 0; m < 4; m++) {
       boxes[n][m][0] /= ratio_w;
       boxes[n][m][1] /= ratio_h;
 
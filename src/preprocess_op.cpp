@@ -14,6 +14,8 @@
 
 #include <include/preprocess_op.h>
 
+#include "opencv2/core/hal/intrin.hpp"
+
 namespace PaddleOCR {
 
 void Permute::Run(const cv::Mat *im, float *data) {
@@ -37,6 +39,20 @@ void PermuteBatch::Run(const std::vector<cv::Mat> imgs, float *data) {
   }
 }
 
+void PackBatch::Run(const std::vector<cv::Mat> &imgs, const int h,
+                    const int w, const cv::Scalar &pad, uint8_t *data) {
+  for (size_t j = 0; j < imgs.size(); j++) {
+    cv::Mat slot(h, w, CV_8UC3, data + j * h * w * 3);
+    int rows = std::min(h, imgs[j].rows);
+    int cols = std::min(w, imgs[j].cols);
+    if (rows < h || cols < w) {
+      slot.setTo(pad);
+    }
+    cv::Rect roi(0, 0, cols, rows);
+    imgs[j](roi).copyTo(slot(roi));
+  }
+}
+
 void Normalize::Run(cv::Mat *im, const std::vector<float> &mean,
                     const std::vector<float> &scale, const bool is_scale) {
   double e = 1.0;
@@ -53,9 +69,9 @@ void Normalize::Run(cv::Mat *im, const std::vector<float> &mean,
   cv::merge(bgr_channels, *im);
 }
 
-void ResizeImgType0::Run(const cv::Mat &img, cv::Mat &resize_img,
-                         std::string limit_type, int limit_side_len,
-                         float &ratio_h, float &ratio_w, bool use_tensorrt) {
+cv::Size ResizeImgType0::TargetSize(const cv::Mat &img,
+                                    const std::string &limit_type,
+                                    int limit_side_len) {
   int w = img.cols;
   int h = img.rows;
   float ratio = 1.f;
@@ -84,29 +100,150 @@ void ResizeImgType0::Run(const cv::Mat &img, cv::Mat &resize_img,
 
   resize_h = std::max(int(round(float(resize_h) / 32) * 32), 32);
   resize_w = std::max(int(round(float(resize_w) / 32) * 32), 32);
+  return cv::Size(resize_w, resize_h);
+}
 
-  cv::resize(img, resize_img, cv::Size(resize_w, resize_h));
-  ratio_h = float(resize_h) / float(h);
-  ratio_w = float(resize_w) / float(w);
+void ResizeImgType0::Run(const cv::Mat &img, cv::Mat &resize_img,
+                         std::string limit_type, int limit_side_len,
+                         float &ratio_h, float &ratio_w, bool use_tensorrt) {
+  cv::Size size = this->TargetSize(img, limit_type, limit_side_len);
+  cv::resize(img, resize_img, size);
+  ratio_h = float(size.height) / float(img.rows);
+  ratio_w = float(size.width) / float(img.cols);
 }
 
-void CrnnResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img, float wh_ratio,
-                        bool use_tensorrt,
-                        const std::vector<int> &rec_image_shape) {
-  int imgC, imgH, imgW;
-  imgC = rec_image_shape[0];
-  imgH = rec_image_shape[1];
-  imgW = rec_image_shape[2];
+void ResizeNormalizePermute::Run(const cv::Mat &img, const cv::Size &size,
+                                 const std::vector<float> &mean,
+                                 const std::vector<float> &scale,
+                                 const bool is_scale, float *data) {
+  CV_Assert(img.type() == CV_8UC3);
+  const int src_h = img.rows;
+  const int src_w = img.cols;
+  const int dst_h = size.height;
+  const int dst_w = size.width;
+  const float scale_x = float(src_w) / dst_w;
+  const float scale_y = float(src_h) / dst_h;
 
-  imgW = int(imgH * wh_ratio);
+  // value * alpha + beta == (value * e - mean) * scale
+  float alpha[3];
+  float beta[3];
+  for (int c = 0; c < 3; c++) {
+    alpha[c] = (is_scale ? 1.f / 255.f : 1.f) * scale[c];
+    beta[c] = -mean[c] * scale[c];
+  }
 
-  float ratio = float(img.cols) / float(img.rows);
-  int resize_w, resize_h;
+  // pixel centers are aligned as in cv::resize with INTER_LINEAR
+  this->xofs0_.resize(dst_w);
+  this->xofs1_.resize(dst_w);
+  this->xalpha_.resize(dst_w);
+  for (int dx = 0; dx < dst_w; dx++) {
+    float sx = (dx + 0.5f) * scale_x - 0.5f;
+    int x0 = int(floorf(sx));
+    float fx = sx - x0;
+    if (x0 < 0) {
+      x0 = 0;
+      fx = 0.f;
+    }
+    if (x0 >= src_w - 1) {
+      x0 = src_w - 1;
+      fx = 0.f;
+    }
+    this->xofs0_[dx] = x0 * 3;
+    this->xofs1_[dx] = std::min(x0 + 1, src_w - 1) * 3;
+    this->xalpha_[dx] = fx;
+  }
+
+  this->rows_.resize(size_t(dst_w) * 6);
+  float *row0 = this->rows_.data();
+  float *row1 = row0 + dst_w * 3;
+  int held0 = -1;
+  int held1 = -1;
+  auto resize_row = [&](int sy, float *row) {
+    const uchar *src = img.ptr<uchar>(sy);
+    for (int dx = 0; dx < dst_w; dx++) {
+      const uchar *p0 = src + this->xofs0_[dx];
+      const uchar *p1 = src + this->xofs1_[dx];
+      float fx = this->xalpha_[dx];
+      for (int c = 0; c < 3; c++) {
+        row[c * dst_w + dx] = p0[c] + fx * (p1[c] - p0[c]);
+      }
+    }
+  };
+
+  const size_t plane = size_t(dst_h) * dst_w;
+  for (int dy = 0; dy < dst_h; dy++) {
+    float sy = (dy + 0.5f) * scale_y - 0.5f;
+    int y0 = int(floorf(sy));
+    float fy = sy - y0;
+    if (y0 < 0) {
+      y0 = 0;
+      fy = 0.f;
+    }
+    if (y0 >= src_h - 1) {
+      y0 = src_h - 1;
+      fy = 0.f;
+    }
+    int y1 = std::min(y0 + 1, src_h - 1);
+
+    // consecutive output rows mostly share source rows, keep them around
+    if (held0 != y0) {
+      if (held1 == y0) {
+        std::swap(row0, row1);
+        std::swap(held0, held1);
+      } else {
+        resize_row(y0, row0);
+        held0 = y0;
+      }
+    }
+    if (held1 != y1) {
+      resize_row(y1, row1);
+      held1 = y1;
+    }
+
+    for (int c = 0; c < 3; c++) {
+      const float *r0 = row0 + c * dst_w;
+      const float *r1 = row1 + c * dst_w;
+      float *out = data + c * plane + size_t(dy) * dst_w;
+      int dx = 0;
+#if CV_SIMD128
+      cv::v_float32x4 v_fy = cv::v_setall_f32(fy);
+      cv::v_float32x4 v_alpha = cv::v_setall_f32(alpha[c]);
+      cv::v_float32x4 v_beta = cv::v_setall_f32(beta[c]);
+      for (; dx <= dst_w - 4; dx += 4) {
+        cv::v_float32x4 v0 = cv::v_load(r0 + dx);
+        cv::v_float32x4 v1 = cv::v_load(r1 + dx);
+        cv::v_float32x4 v = cv::v_muladd(v1 - v0, v_fy, v0);
+        cv::v_store(out + dx, cv::v_muladd(v, v_alpha, v_beta));
+      }
+#endif
+      for (; dx < dst_w; dx++) {
+        float v = r0[dx] + fy * (r1[dx] - r0[dx]);
+        out[dx] = v * alpha[c] + beta[c];
+      }
+    }
+  }
+}
 
+int CrnnResizeImg::ResizeWidth(const cv::Mat &img, float wh_ratio,
+                               const std::vector<int> &rec_image_shape) {
+  int imgH = rec_image_shape[1];
+  int imgW = int(imgH * wh_ratio);
+
+  // a crop warped to the input height keeps its width
+  if (img.rows == imgH)
+    return std::min(img.cols, imgW);
+  float ratio = float(img.cols) / float(img.rows);
   if (ceilf(imgH * ratio) > imgW)
-    resize_w = imgW;
-  else
-    resize_w = int(ceilf(imgH * ratio));
+    return imgW;
+  return int(ceilf(imgH * ratio));
+}
+
+void CrnnResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img, float wh_ratio,
+                        bool use_tensorrt,
+                        const std::vector<int> &rec_image_shape) {
+  int imgH = rec_image_shape[1];
+  int imgW = int(imgH * wh_ratio);
+  int resize_w = this->ResizeWidth(img, wh_ratio, rec_image_shape);
 
   cv::resize(img, resize_img, cv::Size(resize_w, imgH), 0.f, 0.f,
              cv::INTER_LINEAR);
@@ -115,25 +252,70 @@ void CrnnResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img, float wh_ratio,
                      {0, 0, 0});
 }
 
-void ClsResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img,
-                       bool use_tensorrt,
-                       const std::vector<int> &rec_image_shape) {
-  int imgC, imgH, imgW;
-  imgC = rec_image_shape[0];
-  imgH = rec_image_shape[1];
-  imgW = rec_image_shape[2];
+int ClsResizeImg::ResizeWidth(const cv::Mat &img,
+                              const std::vector<int> &rec_image_shape) {
+  int imgH = rec_image_shape[1];
+  int imgW = rec_image_shape[2];
 
+  if (img.rows == imgH)
+    return std::min(img.cols, imgW);
   float ratio = float(img.cols) / float(img.rows);
-  int resize_w, resize_h;
   if (ceilf(imgH * ratio) > imgW)
-    resize_w = imgW;
-  else
-    resize_w = int(ceilf(imgH * ratio));
+    return imgW;
+  return int(ceilf(imgH * ratio));
+}
+
+void ClsResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img,
+                       bool use_tensorrt,
+                       const std::vector<int> &rec_image_shape) {
+  int imgH = rec_image_shape[1];
+  int resize_w = this->ResizeWidth(img, rec_image_shape);
 
   cv::resize(img, resize_img, cv::Size(resize_w, imgH), 0.f, 0.f,
              cv::INTER_LINEAR);
 }
 
+void ResizeNormalizeBatch::Run(const cv::Mat &img, const cv::Size &resize_size,
+                               const int batch_w,
+                               const std::vector<float> &mean,
+                               const std::vector<float> &scale,
+                               const bool is_scale, const bool normalize_pad,
+                               float *data) {
+  const int h = resize_size.height;
+  const int rw = std::min(resize_size.width, batch_w);
+  cv::Mat resize_img = img;
+  // crops already of that size (see Utility::GetRotateCropImage) are read
+  // as they are
+  if (img.size() != resize_size) {
+    this->resize_data_.resize(size_t(h) * resize_size.width * 3);
+    resize_img = cv::Mat(resize_size, CV_8UC3, this->resize_data_.data());
+    cv::resize(img, resize_img, resize_size, 0.f, 0.f, cv::INTER_LINEAR);
+  }
+
+  // value * alpha + beta == (value * e - mean) * scale
+  float alpha[3];
+  float beta[3];
+  for (int c = 0; c < 3; c++) {
+    alpha[c] = (is_scale ? 1.f / 255.f : 1.f) * scale[c];
+    beta[c] = -mean[c] * scale[c];
+  }
+  const size_t plane = size_t(h) * batch_w;
+  for (int y = 0; y < h; y++) {
+    const uchar *src = resize_img.ptr<uchar>(y);
+    float *out0 = data + size_t(y) * batch_w;
+    float *out1 = out0 + plane;
+    float *out2 = out1 + plane;
+    for (int x = 0; x < rw; x++) {
+      out0[x] = src[x * 3] * alpha[0] + beta[0];
+      out1[x] = src[x * 3 + 1] * alpha[1] + beta[1];
+      out2[x] = src[x * 3 + 2] * alpha[2] + beta[2];
+    }
+    std::fill(out0 + rw, out0 + batch_w, normalize_pad ? beta[0] : 0.f);
+    std::fill(out1 + rw, out1 + batch_w, normalize_pad ? beta[1] : 0.f);
+    std::fill(out2 + rw, out2 + batch_w, normalize_pad ? beta[2] : 0.f);
+  }
+}
+
 void TableResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img,
                          const int max_len) {
   int w = img.cols;
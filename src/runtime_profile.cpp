@@ -0,0 +1,350 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <include/args.h>
+#include <include/runtime_profile.h>
+
+#include <onnxruntime_session_options_config_keys.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace PaddleOCR {
+
+namespace {
+
+std::string Trim(const std::string &str) {
+  size_t beg = str.find_first_not_of(" \t\r\n");
+  if (beg == std::string::npos) {
+    return "";
+  }
+  size_t end = str.find_last_not_of(" \t\r\n");
+  return str.substr(beg, end - beg + 1);
+}
+
+bool ParseBool(const std::string &key, const std::string &value) {
+  if (value == "true" || value == "1" || value == "on") {
+    return true;
+  }
+  if (value == "false" || value == "0" || value == "off") {
+    return false;
+  }
+  std::cerr << "[ERROR] runtime option " << key
+            << " expects true or false, got: " << value << std::endl;
+  exit(1);
+}
+
+int ParseInt(const std::string &key, const std::string &value) {
+  std::istringstream in(value);
+  int res = 0;
+  if (!(in >> res) || res < 0) {
+    std::cerr << "[ERROR] runtime option " << key
+              << " expects a non-negative integer, got: " << value
+              << std::endl;
+    exit(1);
+  }
+  return res;
+}
+
+bool IsFlagDefault(const char *name) {
+  return google::GetCommandLineFlagInfoOrDie(name).is_default;
+}
+
+// Lines of --runtime_config: "key=value" applies to every model,
+// "<model>.key=value" only to that model, '#' starts a comment.
+std::vector<std::pair<std::string, std::string>> ReadConfigEntries() {
+  std::vector<std::pair<std::string, std::string>> entries;
+  if (FLAGS_runtime_config.empty()) {
+    return entries;
+  }
+  std::ifstream in(FLAGS_runtime_config);
+  if (!in) {
+    std::cerr << "[ERROR] no such runtime config file: "
+              << FLAGS_runtime_config << std::endl;
+    exit(1);
+  }
+  std::string line;
+  while (getline(in, line)) {
+    line = Trim(line.substr(0, line.find('#')));
+    if (line.empty()) {
+      continue;
+    }
+    size_t pos = line.find('=');
+    if (pos == std::string::npos) {
+      std::cerr << "[ERROR] bad line in runtime config: " << line << std::endl;
+      exit(1);
+    }
+    entries.push_back(std::make_pair(Trim(line.substr(0, pos)),
+                                     Trim(line.substr(pos + 1))));
+  }
+  return entries;
+}
+
+// The config entries, read once. Models loading in parallel ask for them at
+// the same time, the initialization of a local static is thread safe.
+const std::vector<std::pair<std::string, std::string>> &ConfigEntries() {
+  static const std::vector<std::pair<std::string, std::string>> entries =
+      ReadConfigEntries();
+  return entries;
+}
+
+} // namespace
+
+void RuntimeProfile::Set(const std::string &key, const std::string &value) {
+  if (key == "preset") {
+    if (value == "latency") {
+      // one request at a time: every core on the operator, threads stay hot
+      this->intra_op_threads = FLAGS_cpu_threads;
+      this->inter_op_threads = 1;
+      this->parallel_execution = false;
+      this->allow_spinning = true;
+    } else if (value == "throughput") {
+      // many requests in flight: small pools that sleep instead of spinning
+      this->intra_op_threads = 1;
+      this->inter_op_threads = 1;
+      this->parallel_execution = false;
+      this->allow_spinning = false;
+      this->global_thread_pool = false;
+    } else {
+      std::cerr << "[ERROR] runtime preset should be latency or throughput, "
+                << "got: " << value << std::endl;
+      exit(1);
+    }
+  } else if (key == "intra_op_threads") {
+    this->intra_op_threads = ParseInt(key, value);
+  } else if (key == "inter_op_threads") {
+    this->inter_op_threads = ParseInt(key, value);
+  } else if (key == "execution_mode") {
+    if (value != "sequential" && value != "parallel") {
+      std::cerr << "[ERROR] execution_mode should be sequential or parallel, "
+                << "got: " << value << std::endl;
+      exit(1);
+    }
+    this->parallel_execution = value == "parallel";
+  } else if (key == "graph_optimization_level") {
+    if (value != "disable" && value != "basic" && value != "extended" &&
+        value != "all") {
+      std::cerr << "[ERROR] graph_optimization_level should be one of "
+                << "disable/basic/extended/all, got: " << value << std::endl;
+      exit(1);
+    }
+    this->graph_optimization_level = value;
+  } else if (key == "enable_mem_pattern") {
+    this->enable_mem_pattern = ParseBool(key, value);
+  } else if (key == "enable_cpu_mem_arena") {
+    this->enable_cpu_mem_arena = ParseBool(key, value);
+  } else if (key == "allow_spinning") {
+    this->allow_spinning = ParseBool(key, value);
+  } else if (key == "global_thread_pool") {
+    this->global_thread_pool = ParseBool(key, value);
+  } else if (key == "model_cache") {
+    this->model_cache = ParseBool(key, value);
+  } else if (key == "model_cache_dir") {
+    this->model_cache_dir = value;
+  } else if (key == "model_cache_format") {
+    if (value != "onnx" && value != "ort") {
+      std::cerr << "[ERROR] model_cache_format should be onnx or ort, got: "
+                << value << std::endl;
+      exit(1);
+    }
+    this->model_cache_format = value;
+  } else if (key == "load_mode") {
+    if (value != "serial" && value != "parallel" && value != "lazy") {
+      std::cerr << "[ERROR] load_mode should be serial, parallel or lazy, "
+                << "got: " << value << std::endl;
+      exit(1);
+    }
+    this->load_mode = value;
+  } else if (key == "fold_normalize") {
+    this->fold_normalize = ParseBool(key, value);
+  } else if (key == "argmax_output") {
+    this->argmax_output = ParseBool(key, value);
+  } else {
+    std::cerr << "[ERROR] unknown runtime option: " << key << std::endl;
+    exit(1);
+  }
+}
+
+void RuntimeProfile::Parse(const std::string &options) {
+  std::istringstream in(options);
+  std::string item;
+  while (getline(in, item, ',')) {
+    item = Trim(item);
+    if (item.empty()) {
+      continue;
+    }
+    size_t pos = item.find('=');
+    if (pos == std::string::npos) {
+      std::cerr << "[ERROR] runtime option should be key=value, got: " << item
+                << std::endl;
+      exit(1);
+    }
+    this->Set(Trim(item.substr(0, pos)), Trim(item.substr(pos + 1)));
+  }
+}
+
+bool RuntimeProfile::Apply(Ort::SessionOptions &session_options) const {
+  // threads and spinning of the shared pool are fixed when the env is made
+  if (!this->global_thread_pool) {
+    session_options.SetIntraOpNumThreads(this->intra_op_threads);
+    session_options.SetInterOpNumThreads(this->inter_op_threads);
+    session_options.AddConfigEntry(kOrtSessionOptionsConfigAllowIntraOpSpinning,
+                                   this->allow_spinning ? "1" : "0");
+    session_options.AddConfigEntry(kOrtSessionOptionsConfigAllowInterOpSpinning,
+                                   this->allow_spinning ? "1" : "0");
+  }
+  session_options.SetExecutionMode(this->parallel_execution
+                                       ? ExecutionMode::ORT_PARALLEL
+                                       : ExecutionMode::ORT_SEQUENTIAL);
+
+  GraphOptimizationLevel level = GraphOptimizationLevel::ORT_ENABLE_ALL;
+  if (this->graph_optimization_level == "disable") {
+    level = GraphOptimizationLevel::ORT_DISABLE_ALL;
+  } else if (this->graph_optimization_level == "basic") {
+    level = GraphOptimizationLevel::ORT_ENABLE_BASIC;
+  } else if (this->graph_optimization_level == "extended") {
+    level = GraphOptimizationLevel::ORT_ENABLE_EXTENDED;
+  }
+  session_options.SetGraphOptimizationLevel(level);
+
+  if (this->enable_mem_pattern) {
+    session_options.EnableMemPattern();
+  } else {
+    session_options.DisableMemPattern();
+  }
+  if (this->enable_cpu_mem_arena) {
+    session_options.EnableCpuMemArena();
+  } else {
+    session_options.DisableCpuMemArena();
+  }
+
+  bool other_provider = false;
+  if (this->use_mkldnn) {
+    const OrtApi &api = Ort::GetApi();
+    OrtDnnlProviderOptions *dnnl_options = nullptr;
+    OrtStatus *status = api.CreateDnnlProviderOptions(&dnnl_options);
+    if (status == nullptr) {
+      status = api.SessionOptionsAppendExecutionProvider_Dnnl(session_options,
+                                                              dnnl_options);
+      api.ReleaseDnnlProviderOptions(dnnl_options);
+    }
+    if (status != nullptr) {
+      std::cerr << "[WARNING] enable_mkldnn ignored: "
+                << api.GetErrorMessage(status) << std::endl;
+      api.ReleaseStatus(status);
+    } else {
+      other_provider = true;
+    }
+  }
+  return other_provider;
+}
+
+std::string RuntimeProfile::ToString() const {
+  std::ostringstream out;
+  out << "intra_op_threads=" << this->intra_op_threads
+      << ",inter_op_threads=" << this->inter_op_threads << ",execution_mode="
+      << (this->parallel_execution ? "parallel" : "sequential")
+      << ",graph_optimization_level=" << this->graph_optimization_level
+      << ",enable_mem_pattern=" << this->enable_mem_pattern
+      << ",enable_cpu_mem_arena=" << this->enable_cpu_mem_arena
+      << ",allow_spinning=" << this->allow_spinning
+      << ",global_thread_pool=" << this->global_thread_pool
+      << ",use_mkldnn=" << this->use_mkldnn
+      << ",model_cache=" << this->model_cache
+      << ",model_cache_format=" << this->model_cache_format
+      << ",load_mode=" << this->load_mode
+      << ",fold_normalize=" << this->fold_normalize
+      << ",argmax_output=" << this->argmax_output;
+  return out.str();
+}
+
+RuntimeProfile RuntimeProfile::FromFlags(const std::string &model_name) {
+  RuntimeProfile profile;
+  profile.intra_op_threads = FLAGS_cpu_threads;
+  profile.global_thread_pool = FLAGS_use_global_thread_pool;
+  profile.use_mkldnn = FLAGS_enable_mkldnn;
+  profile.model_cache = FLAGS_model_cache;
+  profile.model_cache_dir = FLAGS_model_cache_dir;
+  profile.Set("model_cache_format", FLAGS_model_cache_format);
+  profile.Set("load_mode", FLAGS_model_load_mode);
+  profile.fold_normalize = FLAGS_fold_normalize;
+  profile.argmax_output = FLAGS_argmax_output;
+  if (!FLAGS_runtime_profile.empty()) {
+    profile.Set("preset", FLAGS_runtime_profile);
+  }
+  // page workers run models at the same time: a model with its own pool gets
+  // a share of the cores, the shared pool all of them minus the threads of
+  // the workers, which take part in every Run themselves
+  if (FLAGS_page_workers > 1) {
+    profile.intra_op_threads =
+        model_name.empty()
+            ? std::max(1, profile.intra_op_threads - FLAGS_page_workers + 1)
+            : std::max(1, profile.intra_op_threads / FLAGS_page_workers);
+  }
+  // explicit flags win over the preset
+  if (!IsFlagDefault("intra_op_threads")) {
+    profile.intra_op_threads = FLAGS_intra_op_threads;
+  }
+  if (!IsFlagDefault("inter_op_threads")) {
+    profile.inter_op_threads = FLAGS_inter_op_threads;
+  }
+  if (!IsFlagDefault("execution_mode")) {
+    profile.Set("execution_mode", FLAGS_execution_mode);
+  }
+  if (!IsFlagDefault("graph_optimization_level")) {
+    profile.Set("graph_optimization_level", FLAGS_graph_optimization_level);
+  }
+  if (!IsFlagDefault("enable_mem_pattern")) {
+    profile.enable_mem_pattern = FLAGS_enable_mem_pattern;
+  }
+  if (!IsFlagDefault("enable_cpu_mem_arena")) {
+    profile.enable_cpu_mem_arena = FLAGS_enable_cpu_mem_arena;
+  }
+  if (!IsFlagDefault("allow_spinning")) {
+    profile.allow_spinning = FLAGS_allow_spinning;
+  }
+
+  const std::vector<std::pair<std::string, std::string>> &entries =
+      ConfigEntries();
+  // global entries first, so "<model>.key" always overrides "key"
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (entries[i].first.find('.') == std::string::npos) {
+      profile.Set(entries[i].first, entries[i].second);
+    }
+  }
+  const std::string prefix = model_name + ".";
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (entries[i].first.compare(0, prefix.size(), prefix) == 0) {
+      profile.Set(entries[i].first.substr(prefix.size()), entries[i].second);
+    }
+  }
+
+  if (model_name == "det") {
+    profile.Parse(FLAGS_det_runtime_options);
+  } else if (model_name == "cls") {
+    profile.Parse(FLAGS_cls_runtime_options);
+  } else if (model_name == "rec") {
+    profile.Parse(FLAGS_rec_runtime_options);
+  } else if (model_name == "table") {
+    profile.Parse(FLAGS_table_runtime_options);
+  } else if (model_name == "layout") {
+    profile.Parse(FLAGS_layout_runtime_options);
+  }
+  return profile;
+}
+
+} // namespace PaddleOCR
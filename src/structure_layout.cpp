@@ -32,66 +32,35 @@ void StructureLayoutRecognizer::Run(cv::Mat img,
   cv::Mat srcimg;
   img.copyTo(srcimg);
   cv::Mat resize_img;
-  this->resize_op_.Run(srcimg, resize_img, 800, 608);
-  this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                          this->is_scale_);
-
-  std::vector<float> input(1 * 3 * resize_img.rows * resize_img.cols, 0.0f);
-  this->permute_op_.Run(&resize_img, input.data());
+  if (this->model_.FoldedNormalize()) {
+    uint8_t *input = this->model_.ByteInputData({1, 800, 608, 3});
+    resize_img = cv::Mat(800, 608, CV_8UC3, input);
+    this->resize_op_.Run(srcimg, resize_img, 800, 608);
+  } else {
+    this->resize_op_.Run(srcimg, resize_img, 800, 608);
+    this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
+                            this->is_scale_);
+
+    float *input =
+        this->model_.InputData({1, 3, resize_img.rows, resize_img.cols});
+    this->permute_op_.Run(&resize_img, input);
+  }
   auto preprocess_end = std::chrono::steady_clock::now();
   preprocess_diff += preprocess_end - preprocess_start;
 
-  // get shape of norm_img_batch
-  std::array<int64_t, 4> input_shape{1, 3, resize_img.rows, resize_img.cols};
-
-  // inference with onnx
-  Ort::AllocatorWithDefaultOptions allocator;
-
-  // get input names ptr
-  const size_t in_num = session->GetInputCount();
-  std::vector<Ort::AllocatedStringPtr> input_names_ptr;
-  input_names_ptr.reserve(in_num);
-  for (size_t i = 0; i < in_num; i++) {
-      auto input_name = session->GetInputNameAllocated(i, allocator);
-      input_names_ptr.push_back(std::move(input_name));
-  }
-
-  // get output name ptr
-  const size_t out_num = session->GetOutputCount();
-  std::vector<Ort::AllocatedStringPtr> output_names_ptr;
-  output_names_ptr.reserve(out_num);
-  for (size_t i = 0; i < out_num; i++) {
-      auto output_name = session->GetOutputNameAllocated(i, allocator);
-      output_names_ptr.push_back(std::move(output_name));
-  }
-
   // run
   auto inference_start = std::chrono::steady_clock::now();
-
-  auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
-  std::vector<const char *> input_names = {input_names_ptr.data()->get()};
-  std::vector<const char *> output_names;
-  for (auto& output_name_ptr : output_names_ptr) {
-    output_names.push_back(output_name_ptr.get());
-  }
-
-  Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info, input.data(),
-                                                            input.size(), input_shape.data(),
-                                                            input_shape.size());
-
-  auto output_tensors = session->Run(Ort::RunOptions{nullptr}, input_names.data(), &input_tensor,
-                                     input_names.size(), output_names.data(), output_names.size());
+  this->model_.Run();
 
   // Get output tensor
   std::vector<std::vector<float>> out_tensor_list;
   std::vector<std::vector<int>> output_shape_list;
 
-  for (int j = 0; j < output_names.size(); j++) {
-    std::vector<int64_t> output_shape = output_tensors[j].GetTensorTypeAndShapeInfo().GetShape();
-    int64_t output_count = std::accumulate(output_shape.begin(), output_shape.end(), 1, 
-                                           std::multiplies<int64_t>());
-    float *float_array = output_tensors[j].GetTensorMutableData<float>();
-    std::vector<float> out_data(float_array, float_array + output_count);
+  for (size_t j = 0; j < this->model_.OutputCount(); j++) {
+    const std::vector<int64_t> &output_shape = this->model_.OutputShape(j);
+    const float *float_array = this->model_.OutputData(j);
+    std::vector<float> out_data(float_array,
+                                float_array + this->model_.OutputSize(j));
 
     std::vector<int> int_output_shape;
     for (int i = 0; i < output_shape.size(); i++) {
@@ -100,7 +69,7 @@ void StructureLayoutRecognizer::Run(cv::Mat img,
 
     output_shape_list.push_back(int_output_shape);
     out_tensor_list.push_back(out_data);
-  }                           
+  }
   auto inference_end = std::chrono::steady_clock::now();
   inference_diff += inference_end - inference_start;
 
@@ -129,22 +98,8 @@ void StructureLayoutRecognizer::Run(cv::Mat img,
 }
 
 void StructureLayoutRecognizer::LoadModel(const std::string &model_dir) {
-  std::string model_file = model_dir + "/inference.onnx";
-  this->session = new Ort::Session(this->env, model_file.c_str(), this->sessionOptions);
-  
-  const size_t in_num = session->GetInputCount();
-  Ort::AllocatorWithDefaultOptions allocator;
-  // for (int i = 0; i < in_num; ++i) {
-  //       auto name = session->GetInputNameAllocated(i, allocator);
-  //       std::cout << "Input Name: " << name.get() << std::endl;
-        
-  //       auto type_info = session->GetInputTypeInfo(i);
-  //       auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
-  //       auto input_node_dims = tensor_info.GetShape();
-  //       printf("Input num_dims = %zu\n", input_node_dims.size());
-  //       for (size_t j = 0; j < input_node_dims.size(); j++) {
-  //         printf("Input dim[%zu] = %llu\n",j, input_node_dims[j]);
-  //       }
-  // }
+  this->model_.SetInputNormalize(this->mean_, this->scale_, this->is_scale_);
+  this->model_.LoadModel(model_dir + "/inference.onnx", "structure_layout",
+                         this->runtime_profile_);
 }
 } // namespace PaddleOCR
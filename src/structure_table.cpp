@@ -36,6 +36,7 @@ void StructureTableRecognizer::Run(
     auto preprocess_start = std::chrono::steady_clock::now();
     int end_img_no = std::min(img_num, beg_img_no + this->table_batch_num_);
     int batch_num = end_img_no - beg_img_no;
+    bool folded = this->model_.FoldedNormalize();
     std::vector<cv::Mat> norm_img_batch;
     std::vector<int> width_list;
     std::vector<int> height_list;
@@ -45,73 +46,48 @@ void StructureTableRecognizer::Run(
       cv::Mat resize_img;
       cv::Mat pad_img;
       this->resize_op_.Run(srcimg, resize_img, this->table_max_len_);
-      this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                              this->is_scale_);
-      this->pad_op_.Run(resize_img, pad_img, this->table_max_len_);
-      norm_img_batch.push_back(pad_img);
+      if (folded) {
+        // padded to table_max_len_ while packing
+        norm_img_batch.push_back(resize_img);
+      } else {
+        this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
+                                this->is_scale_);
+        this->pad_op_.Run(resize_img, pad_img, this->table_max_len_);
+        norm_img_batch.push_back(pad_img);
+      }
       width_list.push_back(srcimg.cols);
       height_list.push_back(srcimg.rows);
     }
 
-    std::vector<float> input(
-        batch_num * 3 * this->table_max_len_ * this->table_max_len_, 0.0f);
-    this->permute_op_.Run(norm_img_batch, input.data());
+    if (folded) {
+      uint8_t *input = this->model_.ByteInputData(
+          {batch_num, this->table_max_len_, this->table_max_len_, 3});
+      this->pack_op_.Run(norm_img_batch, this->table_max_len_,
+                         this->table_max_len_,
+                         Utility::NormalizedZero(this->mean_, this->is_scale_),
+                         input);
+    } else {
+      float *input = this->model_.InputData(
+          {batch_num, 3, this->table_max_len_, this->table_max_len_});
+      this->permute_op_.Run(norm_img_batch, input);
+    }
     auto preprocess_end = std::chrono::steady_clock::now();
     preprocess_diff += preprocess_end - preprocess_start;
 
-    // get shape of norm_img_batch
-    std::array<int64_t, 4> input_shape{batch_num, 3, this->table_max_len_, this->table_max_len_};
-
-    // inference with onnx
-    Ort::AllocatorWithDefaultOptions allocator;
-
-    // get input names ptr
-    const size_t in_num = session->GetInputCount();
-    std::vector<Ort::AllocatedStringPtr> input_names_ptr;
-    input_names_ptr.reserve(in_num);
-    for (size_t i = 0; i < in_num; i++) {
-        auto input_name = session->GetInputNameAllocated(i, allocator);
-        input_names_ptr.push_back(std::move(input_name));
-    }
-
-    // get output name ptr
-    const size_t out_num = session->GetOutputCount();
-    std::vector<Ort::AllocatedStringPtr> output_names_ptr;
-    output_names_ptr.reserve(out_num);
-    for (size_t i = 0; i < out_num; i++) {
-        auto output_name = session->GetOutputNameAllocated(i, allocator);
-        output_names_ptr.push_back(std::move(output_name));
-    }
-
     // run
     auto inference_start = std::chrono::steady_clock::now();
-
-    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
-    std::vector<const char *> input_names = {input_names_ptr.data()->get()};
-    std::vector<const char *> output_names;
-    for (auto& output_name_ptr : output_names_ptr) {
-      output_names.push_back(output_name_ptr.get());
-    }
-
-    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info, input.data(),
-                                                              input.size(), input_shape.data(),
-                                                              input_shape.size());
-
-    auto output_tensors = session->Run(Ort::RunOptions{nullptr}, input_names.data(), &input_tensor,
-                                      input_names.size(), output_names.data(), output_names.size());
+    this->model_.Run();
 
     // Get output tensor
-    std::vector<int64_t> predict_shape0_ = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
-    int64_t out_num0 = std::accumulate(predict_shape0_.begin(), predict_shape0_.end(), 1, 
-                                       std::multiplies<int64_t>());                                  
-    float *float_array0 = output_tensors[0].GetTensorMutableData<float>();
-    std::vector<float> loc_preds(float_array0, float_array0 + out_num0);
-
-    std::vector<int64_t> predict_shape1_ = output_tensors[1].GetTensorTypeAndShapeInfo().GetShape();
-    int64_t out_num1 = std::accumulate(predict_shape1_.begin(), predict_shape1_.end(), 1, 
-                                       std::multiplies<int64_t>());                                  
-    float *float_array1 = output_tensors[1].GetTensorMutableData<float>();
-    std::vector<float> structure_probs(float_array1, float_array1 + out_num1);
+    const std::vector<int64_t> &predict_shape0_ = this->model_.OutputShape(0);
+    const float *float_array0 = this->model_.OutputData(0);
+    std::vector<float> loc_preds(float_array0,
+                                 float_array0 + this->model_.OutputSize(0));
+
+    const std::vector<int64_t> &predict_shape1_ = this->model_.OutputShape(1);
+    const float *float_array1 = this->model_.OutputData(1);
+    std::vector<float> structure_probs(
+        float_array1, float_array1 + this->model_.OutputSize(1));
 
     auto inference_end = std::chrono::steady_clock::now();
     inference_diff += inference_end - inference_start;
@@ -161,23 +137,9 @@ void StructureTableRecognizer::Run(
 }
 
 void StructureTableRecognizer::LoadModel(const std::string &model_dir) {
-  std::string model_file = model_dir + "/inference.onnx";
-  this->session = new Ort::Session(this->env, model_file.c_str(), this->sessionOptions);
-  
-  const size_t in_num = session->GetInputCount();
-  Ort::AllocatorWithDefaultOptions allocator;
-  for (int i = 0; i < in_num; ++i) {
-    auto name = session->GetInputNameAllocated(i, allocator);
-    std::cout << "Input Name: " << name.get() << std::endl;
-    
-    auto type_info = session->GetInputTypeInfo(i);
-    auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
-    auto input_node_dims = tensor_info.GetShape();
-    printf("Input num_dims = %zu\n", input_node_dims.size());
-    for (size_t j = 0; j < input_node_dims.size(); j++) {
-        printf("Input dim[%zu] = %llu\n",j, input_node_dims[j]);
-    }
-  }
+  this->model_.SetInputNormalize(this->mean_, this->scale_, this->is_scale_);
+  this->model_.LoadModel(model_dir + "/inference.onnx", "structure_table",
+                         this->runtime_profile_);
 }
 
 } // namespace PaddleOCR
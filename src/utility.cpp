@@ -19,6 +19,8 @@
 
 #include <vector>
 
+#include "opencv2/core/hal/intrin.hpp"
+
 #ifdef _WIN32
 #include <direct.h>
 #else
@@ -131,11 +133,33 @@ void Utility::GetAllFiles(const char *dir_name,
 }
 
 cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage,
-                                    std::vector<std::vector<int>> box) {
-  cv::Mat image;
-  srcimage.copyTo(image);
-  std::vector<std::vector<int>> points = box;
+                                    const std::vector<std::vector<int>> &box) {
+  return GetRotateCropImage(srcimage, BoxToQuad(box));
+}
+
+std::vector<std::vector<int>> Utility::QuadToBox(const Quad &quad) {
+  std::vector<std::vector<int>> box(4);
+  for (int i = 0; i < 4; i++) {
+    box[i] = {quad[i][0], quad[i][1]};
+  }
+  return box;
+}
+
+Quad Utility::BoxToQuad(const std::vector<std::vector<int>> &box) {
+  Quad quad;
+  for (int i = 0; i < 4; i++) {
+    quad[i][0] = box[i][0];
+    quad[i][1] = box[i][1];
+  }
+  return quad;
+}
+
+cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage, const Quad &box) {
+  return GetRotateCropImage(srcimage, box, 0, false);
+}
 
+cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage, const Quad &box,
+                                    int height, bool flip) {
   int x_collect[4] = {box[0][0], box[1][0], box[2][0], box[3][0]};
   int y_collect[4] = {box[0][1], box[1][1], box[2][1], box[3][1]};
   int left = int(*std::min_element(x_collect, x_collect + 4));
@@ -143,10 +167,11 @@ cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage,
   int top = int(*std::min_element(y_collect, y_collect + 4));
   int bottom = int(*std::max_element(y_collect, y_collect + 4));
 
-  cv::Mat img_crop;
-  image(cv::Rect(left, top, right - left, bottom - top)).copyTo(img_crop);
+  // warp from a view of the bounding rect, the page is never copied
+  cv::Mat img_crop = srcimage(cv::Rect(left, top, right - left, bottom - top));
 
-  for (int i = 0; i < points.size(); i++) {
+  Quad points = box;
+  for (int i = 0; i < 4; i++) {
     points[i][0] -= left;
     points[i][1] -= top;
   }
@@ -155,12 +180,55 @@ cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage,
                                 pow(points[0][1] - points[1][1], 2)));
   int img_crop_height = int(sqrt(pow(points[0][0] - points[3][0], 2) +
                                  pow(points[0][1] - points[3][1], 2)));
+  bool vertical = float(img_crop_height) >= float(img_crop_width) * 1.5;
+
+  bool upright = points[0][0] == 0 && points[0][1] == 0 &&
+                 points[1][1] == 0 && points[3][0] == 0 &&
+                 points[1][0] == img_crop.cols &&
+                 points[3][1] == img_crop.rows &&
+                 points[2][0] == img_crop.cols && points[2][1] == img_crop.rows;
+  if (upright && !vertical && !flip && height <= 0) {
+    // the perspective warp of an axis-aligned box is the box itself
+    return img_crop;
+  }
 
+  // Where the box corners end up, in pixels: the upright crop, then
+  // transposed and flipped if it stands vertically, turned by 180 degrees
+  // with `flip` and resized to `height` rows. Each step moves pixels by an
+  // affine map, so one warp through the composed corners samples the page
+  // where the separate steps would, only once.
   cv::Point2f pts_std[4];
   pts_std[0] = cv::Point2f(0., 0.);
   pts_std[1] = cv::Point2f(img_crop_width, 0.);
   pts_std[2] = cv::Point2f(img_crop_width, img_crop_height);
   pts_std[3] = cv::Point2f(0.f, img_crop_height);
+  int dst_w = img_crop_width;
+  int dst_h = img_crop_height;
+  if (vertical) {
+    for (int i = 0; i < 4; i++) {
+      pts_std[i] = cv::Point2f(pts_std[i].y, dst_w - 1 - pts_std[i].x);
+    }
+    std::swap(dst_w, dst_h);
+  }
+  if (flip) {
+    for (int i = 0; i < 4; i++) {
+      pts_std[i] = cv::Point2f(dst_w - 1 - pts_std[i].x,
+                               dst_h - 1 - pts_std[i].y);
+    }
+  }
+  if (height > 0 && dst_h > 0) {
+    // the width rec and cls resize a crop of this aspect ratio to
+    int resize_w = std::max(int(ceilf(float(height) * dst_w / dst_h)), 1);
+    float fx = float(resize_w) / dst_w;
+    float fy = float(height) / dst_h;
+    for (int i = 0; i < 4; i++) {
+      // pixel centers are aligned as in cv::resize
+      pts_std[i] = cv::Point2f((pts_std[i].x + 0.5f) * fx - 0.5f,
+                               (pts_std[i].y + 0.5f) * fy - 0.5f);
+    }
+    dst_w = resize_w;
+    dst_h = height;
+  }
 
   cv::Point2f pointsf[4];
   pointsf[0] = cv::Point2f(points[0][0], points[0][1]);
@@ -168,20 +236,45 @@ cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage,
   pointsf[2] = cv::Point2f(points[2][0], points[2][1]);
   pointsf[3] = cv::Point2f(points[3][0], points[3][1]);
 
-  cv::Mat M = cv::getPerspectiveTransform(pointsf, pts_std);
-
+  // the fourth corner where a parallelogram would have it, within a pixel
+  bool parallel = std::abs(points[0][0] + points[2][0] - points[1][0] -
+                           points[3][0]) <= 1 &&
+                  std::abs(points[0][1] + points[2][1] - points[1][1] -
+                           points[3][1]) <= 1;
   cv::Mat dst_img;
-  cv::warpPerspective(img_crop, dst_img, M,
-                      cv::Size(img_crop_width, img_crop_height),
-                      cv::BORDER_REPLICATE);
-
-  if (float(dst_img.rows) >= float(dst_img.cols) * 1.5) {
-    cv::Mat srcCopy = cv::Mat(dst_img.rows, dst_img.cols, dst_img.depth());
-    cv::transpose(dst_img, srcCopy);
-    cv::flip(srcCopy, srcCopy, 0);
-    return srcCopy;
+  if (parallel) {
+    // three corners fix an affine map, which is cheaper to apply
+    cv::Point2f src3[3] = {pointsf[0], pointsf[1], pointsf[3]};
+    cv::Point2f dst3[3] = {pts_std[0], pts_std[1], pts_std[3]};
+    cv::Mat M = cv::getAffineTransform(src3, dst3);
+    cv::warpAffine(img_crop, dst_img, M, cv::Size(dst_w, dst_h),
+                   cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  } else {
+    cv::Mat M = cv::getPerspectiveTransform(pointsf, pts_std);
+    cv::warpPerspective(img_crop, dst_img, M, cv::Size(dst_w, dst_h),
+                        cv::BORDER_REPLICATE);
+  }
+  return dst_img;
+}
+
+void Utility::GetRotateCropImages(const cv::Mat &srcimage,
+                                  const std::vector<OCRPredictResult> &results,
+                                  std::vector<cv::Mat> &crops, int height) {
+  size_t offset = crops.size();
+  int n = int(results.size());
+  crops.resize(offset + n);
+  auto body = [&](const cv::Range &range) {
+    for (int i = range.start; i < range.end; i++) {
+      crops[offset + i] =
+          GetRotateCropImage(srcimage, BoxToQuad(results[i].box), height,
+                             false);
+    }
+  };
+  // a few boxes are not worth waking up the pool
+  if (n >= 8) {
+    cv::parallel_for_(cv::Range(0, n), body, n / 4.);
   } else {
-    return dst_img;
+    body(cv::Range(0, n));
   }
 }
 
@@ -255,7 +348,7 @@ void Utility::print_result(const std::vector<OCRPredictResult> &ocr_result) {
   for (int i = 0; i < ocr_result.size(); i++) {
     std::cout << i << "\t";
     // det
-    std::vector<std::vector<int>> boxes = ocr_result[i].box;
+    const std::vector<std::vector<int>> &boxes = ocr_result[i].box;
     if (boxes.size() > 0) {
       std::cout << "det boxes: [";
       for (int n = 0; n < boxes.size(); n++) {
@@ -304,21 +397,47 @@ cv::Mat Utility::crop_image(cv::Mat &img, const std::vector<float> &box) {
   return crop_image(img, box_int);
 }
 
-void Utility::sorted_boxes(std::vector<OCRPredictResult> &ocr_result) {
-  std::sort(ocr_result.begin(), ocr_result.end(), Utility::comparison_box);
-  if (ocr_result.size() > 0) {
-    for (int i = 0; i < ocr_result.size() - 1; i++) {
-      for (int j = i; j >= 0; j--) {
-        if (abs(ocr_result[j + 1].box[0][1] - ocr_result[j].box[0][1]) < 10 &&
-            (ocr_result[j + 1].box[0][0] < ocr_result[j].box[0][0])) {
-          std::swap(ocr_result[i], ocr_result[i + 1]);
-        }
+namespace {
+
+// top-left corner of a result or box, x and y at [0][0] and [0][1]
+const std::vector<std::vector<int>> &BoxOf(const OCRPredictResult &result) {
+  return result.box;
+}
+const Quad &BoxOf(const Quad &box) { return box; }
+
+// Top to bottom by the top-left corner, left to right on ties, then the
+// pass that moves boxes whose corners are within 10 pixels in height into
+// left to right order.
+template <class T> void SortBoxes(std::vector<T> &items) {
+  std::sort(items.begin(), items.end(), [](const T &item1, const T &item2) {
+    if (BoxOf(item1)[0][1] != BoxOf(item2)[0][1]) {
+      return BoxOf(item1)[0][1] < BoxOf(item2)[0][1];
+    }
+    return BoxOf(item1)[0][0] < BoxOf(item2)[0][0];
+  });
+  for (int i = 0; i + 1 < int(items.size()); i++) {
+    for (int j = i; j >= 0; j--) {
+      if (abs(BoxOf(items[j + 1])[0][1] - BoxOf(items[j])[0][1]) < 10 &&
+          (BoxOf(items[j + 1])[0][0] < BoxOf(items[j])[0][0])) {
+        std::swap(items[i], items[i + 1]);
       }
     }
   }
 }
 
+} // namespace
+
+void Utility::sorted_boxes(std::vector<OCRPredictResult> &ocr_result) {
+  SortBoxes(ocr_result);
+}
+
+void Utility::sorted_boxes(std::vector<Quad> &boxes) { SortBoxes(boxes); }
+
 std::vector<int> Utility::xyxyxyxy2xyxy(std::vector<std::vector<int>> &box) {
+  return xyxyxyxy2xyxy(BoxToQuad(box));
+}
+
+std::vector<int> Utility::xyxyxyxy2xyxy(const Quad &box) {
   int x_collect[4] = {box[0][0], box[1][0], box[2][0], box[3][0]};
   int y_collect[4] = {box[0][1], box[1][1], box[2][1], box[3][1]};
   int left = int(*std::min_element(x_collect, x_collect + 4));
@@ -348,6 +467,56 @@ std::vector<int> Utility::xyxyxyxy2xyxy(std::vector<int> &box) {
   return box1;
 }
 
+int Utility::ArgmaxValue(const float *data, int n, float &max_value) {
+  int i = 1;
+  int best = 0;
+  float best_value = data[0];
+#if CV_SIMD128
+  if (n >= 8) {
+    // per lane maximum and where it was first seen
+    cv::v_float32x4 v_max = cv::v_load(data);
+    cv::v_int32x4 v_idx(0, 1, 2, 3);
+    cv::v_int32x4 v_cur = v_idx;
+    const cv::v_int32x4 v_four = cv::v_setall_s32(4);
+    for (i = 4; i <= n - 4; i += 4) {
+      cv::v_float32x4 v = cv::v_load(data + i);
+      cv::v_float32x4 mask = v > v_max;
+      v_cur += v_four;
+      v_max = cv::v_select(mask, v, v_max);
+      v_idx = cv::v_select(cv::v_reinterpret_as_s32(mask), v_cur, v_idx);
+    }
+    float lane_value[4];
+    int lane_idx[4];
+    cv::v_store(lane_value, v_max);
+    cv::v_store(lane_idx, v_idx);
+    best = lane_idx[0];
+    best_value = lane_value[0];
+    for (int k = 1; k < 4; k++) {
+      if (lane_value[k] > best_value ||
+          (lane_value[k] == best_value && lane_idx[k] < best)) {
+        best = lane_idx[k];
+        best_value = lane_value[k];
+      }
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    if (data[i] > best_value) {
+      best = i;
+      best_value = data[i];
+    }
+  }
+  max_value = best_value;
+  return best;
+}
+
+cv::Scalar Utility::NormalizedZero(const std::vector<float> &mean,
+                                   const bool is_scale) {
+  double e = is_scale ? 255.0 : 1.0;
+  return cv::Scalar(std::round(mean[0] * e), std::round(mean[1] * e),
+                    std::round(mean[2] * e));
+}
+
 float Utility::fast_exp(float x) {
   union {
     uint32_t i;